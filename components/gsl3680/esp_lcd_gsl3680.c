@@ -6,12 +6,14 @@
 #include "esp_err.h"
 #include "esp_log.h"
 #include "esp_check.h"
+#include "esp_timer.h"
 #include "driver/gpio.h"
 #include "driver/i2c_master.h"
 #include "esp_lcd_panel_io.h"
 #include "esp_lcd_touch.h"
 #include "esp_lcd_gsl3680.h"
 #include "gsl_point_id.h"
+#include "gsl_config_data.h"
 
 #define TAG "gsl3680"
 
@@ -21,118 +23,9 @@
 /* gsl3680 support key num */
 #define ESP_gsl3680_TOUCH_MAX_BUTTONS         (9)
 
+/* Longer gaps between touched frames are a new touch, not the frame rate */
+#define GSL3680_FRAME_GAP_MAX_US              (100000)
 
-unsigned int gsl_config_data_id[] =
-{
-	0xccb69a,  
-	0x200,
-	0,0,
-	0,
-	0,0,0,
-	0,0,0,0,0,0,0,0x1cc86fd6,
-
-
-	0x40000d00,0xa,0xe001a,0xe001a,0x3200500,0,0x5100,0x8e00,
-	0,0x320014,0,0x14,0,0,0,0,
-	0x8,0x4000,0x1000,0x10170002,0x10110000,0,0,0x4040404,
-	0x1b6db688,0x64,0xb3000f,0xad0019,0xa60023,0xa0002d,0xb3000f,0xad0019,
-	0xa60023,0xa0002d,0xb3000f,0xad0019,0xa60023,0xa0002d,0xb3000f,0xad0019,
-	0xa60023,0xa0002d,0x804000,0x90040,0x90001,0,0,0,
-	0,0,0,0x14012c,0xa003c,0xa0078,0x400,0x1081,
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-
-	0,//key_map
-	0x3200384,0x64,0x503e8,//0
-	0,0,0,//1
-	0,0,0,//2
-	0,0,0,//3
-	0,0,0,//4
-	0,0,0,//5
-	0,0,0,//6
-	0,0,0,//7
-
-	0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-
-
-	0x220,
-	0,0,0,0,0,0,0,0,
-	0x10203,0x4050607,0x8090a0b,0xc0d0e0f,0x10111213,0x14151617,0x18191a1b,0x1c1d1e1f,
-	0x20212223,0x24252627,0x28292a2b,0x2c2d2e2f,0x30313233,0x34353637,0x38393a3b,0x3c3d3e3f,
-	0x10203,0x4050607,0x8090a0b,0xc0d0e0f,0x10111213,0x14151617,0x18191a1b,0x1c1d1e1f,
-	0x20212223,0x24252627,0x28292a2b,0x2c2d2e2f,0x30313233,0x34353637,0x38393a3b,0x3c3d3e3f,
-
-	0x10203,0x4050607,0x8090a0b,0xc0d0e0f,0x10111213,0x14151617,0x18191a1b,0x1c1d1e1f,
-	0x20212223,0x24252627,0x28292a2b,0x2c2d2e2f,0x30313233,0x34353637,0x38393a3b,0x3c3d3e3f,
-
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-
-	0x10203,0x4050607,0x8090a0b,0xc0d0e0f,0x10111213,0x14151617,0x18191a1b,0x1c1d1e1f,
-	0x20212223,0x24252627,0x28292a2b,0x2c2d2e2f,0x30313233,0x34353637,0x38393a3b,0x3c3d3e3f,
-
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,
-
-
-	0x3,
-	0x101,0,0x100,0,
-	0x20,0x10,0x8,0x4,
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-
-	0x4,0,0,0,0,0,0,0,
-	0x3800680,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,0,
-	0,0,0,0,0,0,0,
-};
-
-
-
-static TG_STATE_E tpc_gesture_id = TG_UNKNOWN_STATE;
-static XY_DATA_T XY_Coordinate[MAX_FINGER_NUM]={0};
-esp_lcd_touch_handle_t esp_lcd_touch_gsl3680;
-
-static uint8_t Finger_num = 0;
-static TP_STATE_E tp_event = TP_PEN_NONE;
-static uint8_t pre_pen_flag = 0;
-static uint32_t pre_distance=0;
-static uint32_t distance_flag = 0;
-static uint16_t x_new = 0;
-static uint16_t y_new = 0;
-static uint16_t x_start = 0 , y_start = 0;
-static uint8_t zoomOutDebounce = 0;
-static uint8_t zoomInDebounce = 0;
 
 static esp_err_t esp_lcd_touch_gsl3680_read_data(esp_lcd_touch_handle_t tp);
 static bool esp_lcd_touch_gsl3680_get_xy(esp_lcd_touch_handle_t tp, uint16_t *x, uint16_t *y, uint16_t *strength, uint8_t *point_num, uint8_t max_point_num);
@@ -143,34 +36,194 @@ static esp_err_t esp_lcd_touch_gsl3680_del(esp_lcd_touch_handle_t tp);
 
 /* I2C read/write */
 static esp_err_t touch_gsl3680_i2c_read(esp_lcd_touch_handle_t tp, uint16_t reg, uint8_t *data, uint8_t len);
-static esp_err_t touch_gsl3680_i2c_write(esp_lcd_touch_handle_t tp, uint16_t reg, uint8_t *data, uint8_t len);
-
-/* gsl3680 reset */
-static esp_err_t touch_gsl3680_reset(esp_lcd_touch_handle_t tp);
-/* Read status and config register */
-static esp_err_t touch_gsl3680_read_cfg(esp_lcd_touch_handle_t tp);
+static esp_err_t touch_gsl3680_i2c_write(esp_lcd_touch_handle_t tp, uint16_t reg, const uint8_t *data, uint8_t len);
 
 /* gsl3680 enter/exit sleep mode */
 static esp_err_t esp_lcd_touch_gsl3680_enter_sleep(esp_lcd_touch_handle_t tp);
 static esp_err_t esp_lcd_touch_gsl3680_exit_sleep(esp_lcd_touch_handle_t tp);
-static esp_err_t esp_lcd_touch_gsl3680_startup_chip(esp_lcd_touch_handle_t tp);
-static esp_err_t esp_lcd_touch_gsl3680_read_ram_fw(esp_lcd_touch_handle_t tp);
-static esp_err_t esp_lcd_touch_gsl3680_load_fw(esp_lcd_touch_handle_t tp);
-static esp_err_t esp_lcd_touch_gsl3680_clear_reg(esp_lcd_touch_handle_t tp);
-static esp_err_t esp_lcd_touch_gsl3680_init(esp_lcd_touch_handle_t tp);
-static TP_STATE_E _Get_Cal_msg(void);
+
+/* Bring-up sequence. Every register write or pin change is one step followed
+ * by a pause; esp_lcd_touch_gsl3680_bringup_poll() runs one due step per call
+ * so the caller never sleeps, the blocking constructor just waits between them. */
+enum {
+    GSL_OP_WAIT,            /* nothing, just the pause */
+    GSL_OP_RST,             /* reset pin to data[0] */
+    GSL_OP_RST_CFG,         /* reset pin to the configured active level if data[0], else released */
+    GSL_OP_INT,             /* interrupt pin to data[0] */
+    GSL_OP_WRITE,           /* write len bytes of data to reg */
+    GSL_OP_DUMP,            /* read and log 4 bytes of reg */
+    GSL_OP_CHECK_RUN,       /* read 4 bytes of reg, fail unless they equal data */
+    GSL_OP_DATA_INIT,       /* hand the config to the point id algorithm */
+};
+
+typedef struct {
+    uint8_t op;
+    uint8_t reg;
+    uint8_t len;
+    uint8_t delay_ms;       /* pause after the step */
+    uint8_t data[4];
+} gsl3680_step_t;
+
+#define GSL_SCRIPT(s) (s), (sizeof(s) / sizeof((s)[0]))
+
+/* Reset and pull INT low to select the I2C address */
+static const gsl3680_step_t gsl3680_power_on_script[] = {
+    { .op = GSL_OP_RST_CFG, .data = { 1 } },
+    { .op = GSL_OP_INT, .delay_ms = 10, .data = { 0 } },
+    { .op = GSL_OP_INT, .delay_ms = 1, .data = { 0 } },
+    { .op = GSL_OP_RST_CFG, .delay_ms = 60, .data = { 0 } },
+};
+
+/* Read status and config register */
+static const gsl3680_step_t gsl3680_read_cfg_script[] = {
+    { .op = GSL_OP_DUMP, .reg = 0xf0, .len = 4, .delay_ms = 20 },
+    { .op = GSL_OP_WRITE, .reg = 0xf0, .len = 4, .delay_ms = 20, .data = { 0x12, 0x34, 0x56 } },
+    { .op = GSL_OP_DUMP, .reg = 0xf0, .len = 4 },
+};
+
+/* Pulse reset and halt the core */
+static const gsl3680_step_t gsl3680_reset_script[] = {
+    { .op = GSL_OP_RST, .delay_ms = 20, .data = { 0 } },
+    { .op = GSL_OP_RST, .delay_ms = 20, .data = { 1 } },
+    { .op = GSL_OP_WRITE, .reg = 0xe0, .len = 1, .delay_ms = 10, .data = { 0x88 } },
+    { .op = GSL_OP_WRITE, .reg = 0xe4, .len = 1, .delay_ms = 10, .data = { 0x04 } },
+    { .op = GSL_OP_WRITE, .reg = 0xbc, .len = 4, .delay_ms = 10, .data = { 0x00, 0x00, 0x00, 0x00 } },
+};
+
+static const gsl3680_step_t gsl3680_clear_reg_script[] = {
+    { .op = GSL_OP_WRITE, .reg = 0xe0, .len = 1, .delay_ms = 20, .data = { 0x88 } },
+    { .op = GSL_OP_WRITE, .reg = 0x88, .len = 1, .delay_ms = 5, .data = { 0x01 } },
+    { .op = GSL_OP_WRITE, .reg = 0xe4, .len = 1, .delay_ms = 5, .data = { 0x04 } },
+    { .op = GSL_OP_WRITE, .reg = 0xe0, .len = 1, .delay_ms = 20, .data = { 0x00 } },
+};
+
+static const gsl3680_step_t gsl3680_startup_script[] = {
+    { .op = GSL_OP_WRITE, .reg = 0xe0, .len = 1, .delay_ms = 10, .data = { 0x00 } },
+    { .op = GSL_OP_DATA_INIT },
+};
+
+/* The firmware reports 0x5a5a5a5a in 0xb0 once it runs */
+static const gsl3680_step_t gsl3680_read_ram_fw_script[] = {
+    { .op = GSL_OP_WAIT, .delay_ms = 30 },
+    { .op = GSL_OP_CHECK_RUN, .reg = 0xb0, .len = 4, .data = { 0x5a, 0x5a, 0x5a, 0x5a } },
+};
+
+typedef enum {
+    GSL_BRINGUP_POWER_ON,
+    GSL_BRINGUP_READ_CFG,
+    GSL_BRINGUP_CHECK_RESET,     /* warm start: is the firmware already in RAM? */
+    GSL_BRINGUP_CHECK_SIG,
+    GSL_BRINGUP_CHECK_STARTUP,
+    GSL_BRINGUP_CHECK_RUN,
+    GSL_BRINGUP_CLEAR_REG,       /* cold start: upload the firmware */
+    GSL_BRINGUP_RESET,
+    GSL_BRINGUP_LOAD_FW,
+    GSL_BRINGUP_STARTUP,
+    GSL_BRINGUP_RESET_AGAIN,
+    GSL_BRINGUP_STARTUP_AGAIN,
+    GSL_BRINGUP_VERIFY,
+    GSL_BRINGUP_INT_SETUP,
+    GSL_BRINGUP_READY,
+    GSL_BRINGUP_FAILED,
+} gsl3680_bringup_stage_t;
+
+/* Firmware upload position, kept between polls */
+typedef struct {
+    size_t pos;             /* packed blob offset of the current segment, or GSLX680_FW index */
+    size_t done;            /* words of the current packed segment already written */
+    int page;               /* page currently selected, -1 before the first select */
+    size_t words;
+    size_t writes;
+} gsl3680_fw_cursor_t;
+
+typedef struct {
+    gsl3680_bringup_stage_t stage;
+    uint8_t step;           /* next step of the stage script */
+    int64_t wake_us;        /* the next step is due at this esp_timer time */
+    int64_t stage_us;       /* start of the warm check or of the cold sequence */
+    esp_err_t result;
+    gsl3680_fw_cursor_t fw;
+} gsl3680_bringup_t;
+
+/* Everything one controller needs, so several panels can run side by side.
+ * base comes first: the esp_lcd_touch handle is converted back with __containerof. */
+typedef struct {
+    esp_lcd_touch_t base;
+    struct gsl_alg_ctx *alg;    /* point id algorithm state, gsl_alg_ctx_size() bytes */
+    gsl3680_bringup_t bringup;
+    esp_lcd_touch_gsl3680_boot_info_t boot_info;
+    esp_lcd_touch_gsl3680_read_stats_t read_stats;
+    struct gsl_delay_stat delay_stat;   /* copy of the algorithm counters, taken under the lock */
+    int64_t touch_us;           /* last read that found a finger, 0 after an empty one */
+    uint32_t frame_us;          /* running average of the time between touched reads */
+
+    XY_DATA_T XY_Coordinate[MAX_FINGER_NUM];
+    uint8_t Finger_num;
+
+    /* gesture detection */
+    TG_STATE_E tpc_gesture_id;
+    TP_STATE_E tp_event;
+    uint8_t pre_pen_flag;
+    uint32_t pre_distance;
+    uint32_t distance_flag;
+    uint16_t x_new;
+    uint16_t y_new;
+    uint16_t x_start, y_start;
+    uint8_t zoomOutDebounce;
+    uint8_t zoomInDebounce;
+} gsl3680_dev_t;
+
+#define GSL3680_DEV(tp) __containerof(tp, gsl3680_dev_t, base)
+
+static esp_err_t touch_gsl3680_bringup_stage(esp_lcd_touch_handle_t tp, uint32_t *delay_ms);
+static void touch_gsl3680_bringup_next(esp_lcd_touch_handle_t tp, esp_err_t ret);
+static esp_err_t touch_gsl3680_run_step(esp_lcd_touch_handle_t tp, const gsl3680_step_t *script, size_t len, uint32_t *delay_ms);
+static esp_err_t touch_gsl3680_int_setup(esp_lcd_touch_handle_t tp);
+static esp_err_t esp_lcd_touch_gsl3680_check_sig(esp_lcd_touch_handle_t tp);
+static esp_err_t esp_lcd_touch_gsl3680_load_fw(esp_lcd_touch_handle_t tp, gsl3680_fw_cursor_t *fw, uint32_t budget_us);
+static esp_err_t esp_lcd_touch_gsl3680_load_fw_packed(esp_lcd_touch_handle_t tp, gsl3680_fw_cursor_t *fw, const uint8_t *blob, size_t len, size_t burst);
+#ifndef ESP_LCD_TOUCH_GSL3680_PACKED_FW
+static esp_err_t esp_lcd_touch_gsl3680_load_fw_table(esp_lcd_touch_handle_t tp, gsl3680_fw_cursor_t *fw, size_t burst);
+#endif
+static TP_STATE_E _Get_Cal_msg(gsl3680_dev_t *dev);
 
 esp_err_t esp_lcd_touch_new_i2c_gsl3680(esp_lcd_panel_io_handle_t io, const esp_lcd_touch_config_t *config, esp_lcd_touch_handle_t *out_touch)
+{
+    esp_err_t ret = esp_lcd_touch_new_i2c_gsl3680_async(io, config, out_touch);
+
+    if (ret == ESP_OK) {
+        /* Same sequence as the polled bring-up, sleeping until each step is due */
+        while ((ret = esp_lcd_touch_gsl3680_bringup_poll(*out_touch)) == ESP_ERR_NOT_FINISHED) {
+            int64_t wait_us = GSL3680_DEV(*out_touch)->bringup.wake_us - esp_timer_get_time();
+            TickType_t ticks = wait_us > 0 ? pdMS_TO_TICKS((wait_us + 999) / 1000) : 0;
+            vTaskDelay(ticks ? ticks : 1);
+        }
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error (0x%x)! Touch controller GSL3680 initialization failed!", ret);
+        if (*out_touch) {
+            esp_lcd_touch_gsl3680_del(*out_touch);
+            *out_touch = NULL;
+        }
+    }
+
+    return ret;
+}
+
+esp_err_t esp_lcd_touch_new_i2c_gsl3680_async(esp_lcd_panel_io_handle_t io, const esp_lcd_touch_config_t *config, esp_lcd_touch_handle_t *out_touch)
 {
      esp_err_t ret = ESP_OK;
+    esp_lcd_touch_handle_t esp_lcd_touch_gsl3680 = NULL;
+    gsl3680_dev_t *dev;
 
     assert(io != NULL);
     assert(config != NULL);
     assert(out_touch != NULL);
 
     /* Prepare main structure */
-    esp_lcd_touch_gsl3680 = heap_caps_calloc(1, sizeof(esp_lcd_touch_t), MALLOC_CAP_DEFAULT);
-    ESP_GOTO_ON_FALSE(esp_lcd_touch_gsl3680, ESP_ERR_NO_MEM, err, TAG, "no mem for GSL3680 controller");
+    dev = heap_caps_calloc(1, sizeof(gsl3680_dev_t), MALLOC_CAP_DEFAULT);
+    ESP_GOTO_ON_FALSE(dev, ESP_ERR_NO_MEM, err, TAG, "no mem for GSL3680 controller");
+    esp_lcd_touch_gsl3680 = &dev->base;
 
     /* Communication interface */
     esp_lcd_touch_gsl3680->io = io;
@@ -190,7 +243,10 @@ esp_err_t esp_lcd_touch_new_i2c_gsl3680(esp_lcd_panel_io_handle_t io, const esp_
 
     /* Save config */
     memcpy(&esp_lcd_touch_gsl3680->config, config, sizeof(esp_lcd_touch_config_t));
-    //esp_lcd_touch_io_gsl3680_config_t *gsl3680_config = (esp_lcd_touch_io_gsl3680_config_t *)esp_lcd_touch_gsl3680->config.driver_data;
+
+    /* Point id algorithm state, initialized by the bring-up */
+    dev->alg = heap_caps_calloc(1, gsl_alg_ctx_size(), MALLOC_CAP_DEFAULT);
+    ESP_GOTO_ON_FALSE(dev->alg, ESP_ERR_NO_MEM, err, TAG, "no mem for GSL3680 point id state");
 
     /* Prepare pin for touch controller reset */
     if (esp_lcd_touch_gsl3680->config.rst_gpio_num != GPIO_NUM_NC) {
@@ -203,7 +259,7 @@ esp_err_t esp_lcd_touch_new_i2c_gsl3680(esp_lcd_panel_io_handle_t io, const esp_
     }
 
     if (esp_lcd_touch_gsl3680->config.rst_gpio_num != GPIO_NUM_NC && esp_lcd_touch_gsl3680->config.int_gpio_num != GPIO_NUM_NC) {
-        /* Prepare pin for touch controller int */
+        /* Prepare pin for touch controller int, it selects the I2C address while reset is released */
         const gpio_config_t int_gpio_config = {
             .mode = GPIO_MODE_OUTPUT,
             .intr_type = GPIO_INTR_DISABLE,
@@ -213,61 +269,21 @@ esp_err_t esp_lcd_touch_new_i2c_gsl3680(esp_lcd_panel_io_handle_t io, const esp_
         };
         ret = gpio_config(&int_gpio_config);
         ESP_GOTO_ON_ERROR(ret, err, TAG, "GPIO config failed");
-
-        ESP_RETURN_ON_ERROR(gpio_set_level(esp_lcd_touch_gsl3680->config.rst_gpio_num, esp_lcd_touch_gsl3680->config.levels.reset), TAG, "GPIO set level error!");
-        ESP_RETURN_ON_ERROR(gpio_set_level(esp_lcd_touch_gsl3680->config.int_gpio_num, 0), TAG, "GPIO set level error!");
-        vTaskDelay(pdMS_TO_TICKS(10));
-
-        /* Select I2C addr, set output high or low */
-        uint32_t gpio_level = 0;
-        //if (ESP_LCD_TOUCH_IO_I2C_GSL3680_ADDRESS == gsl3680_config->dev_addr) {
-            //gpio_level = 0;
-        //} else {
-            //gpio_level = 0;
-           // ESP_LOGE(TAG, "Addr (0x%X) is invalid", gsl3680_config->dev_addr);
-        //}
-        ESP_RETURN_ON_ERROR(gpio_set_level(esp_lcd_touch_gsl3680->config.int_gpio_num, gpio_level), TAG, "GPIO set level error!");
-        vTaskDelay(pdMS_TO_TICKS(1));
-
-        ESP_RETURN_ON_ERROR(gpio_set_level(esp_lcd_touch_gsl3680->config.rst_gpio_num, !esp_lcd_touch_gsl3680->config.levels.reset), TAG, "GPIO set level error!");
-        vTaskDelay(pdMS_TO_TICKS(10));
-
-        vTaskDelay(pdMS_TO_TICKS(50));
     } else {
         ESP_LOGW(TAG, "Unable to initialize the I2C address");
-        /* Reset controller */
-        ret = touch_gsl3680_reset(esp_lcd_touch_gsl3680);
-        ESP_GOTO_ON_ERROR(ret, err, TAG, "GSL3680 reset failed");
     }
 
-    /* Read status and config info */
-    ESP_LOGI(TAG,"init gls3680");
-    touch_gsl3680_read_cfg(esp_lcd_touch_gsl3680);
-    esp_lcd_touch_gsl3680_init(esp_lcd_touch_gsl3680);
-    ret = esp_lcd_touch_gsl3680_read_ram_fw(esp_lcd_touch_gsl3680);
-    // touch_gsl3680_read_cfg(esp_lcd_touch_gsl3680);
-
-    /* Prepare pin for touch interrupt */
-    if (esp_lcd_touch_gsl3680->config.int_gpio_num != GPIO_NUM_NC) {
-        const gpio_config_t int_gpio_config = {
-            .mode = GPIO_MODE_INPUT,
-            .intr_type = (esp_lcd_touch_gsl3680->config.levels.interrupt ? GPIO_INTR_POSEDGE : GPIO_INTR_NEGEDGE),
-            .pin_bit_mask = BIT64(esp_lcd_touch_gsl3680->config.int_gpio_num)
-        };
-        ret = gpio_config(&int_gpio_config);
-        ESP_GOTO_ON_ERROR(ret, err, TAG, "GPIO config failed");
+    dev->tpc_gesture_id = TG_UNKNOWN_STATE;
+    dev->tp_event = TP_PEN_NONE;
+    dev->bringup.stage = GSL_BRINGUP_POWER_ON;
+    dev->bringup.wake_us = esp_timer_get_time();
 
-        /* Register interrupt callback */
-        if (esp_lcd_touch_gsl3680->config.interrupt_callback) {
-            esp_lcd_touch_register_interrupt_callback(esp_lcd_touch_gsl3680, esp_lcd_touch_gsl3680->config.interrupt_callback);
-        }
-    }
- 
 err:
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Error (0x%x)! Touch controller GSL3680 initialization failed!", ret);
         if (esp_lcd_touch_gsl3680) {
             esp_lcd_touch_gsl3680_del(esp_lcd_touch_gsl3680);
+            esp_lcd_touch_gsl3680 = NULL;
         }
     }
 
@@ -303,12 +319,17 @@ static esp_err_t esp_lcd_touch_gsl3680_exit_sleep(esp_lcd_touch_handle_t tp)
 
 static esp_err_t esp_lcd_touch_gsl3680_read_data(esp_lcd_touch_handle_t tp)
 {
+    gsl3680_dev_t *dev = GSL3680_DEV(tp);
     esp_err_t err;
-    uint8_t touch_data[24];
+    const esp_lcd_touch_io_gsl3680_config_t *gsl3680_config = tp->config.driver_data;
+    uint8_t touch_data[4 + MAX_FINGER_NUM * 4] = {0};
     uint8_t touch_cnt = 0;
+    uint8_t max_points = MAX_FINGER_NUM;
+    bool idle = false;
     uint16_t x_poit, y_poit, x2_poit, y2_poit;
 	uint16_t  distance = 0, chazhi = 0;
     size_t i = 0;
+    int64_t now_us;
 
     assert(tp != NULL);
 
@@ -318,10 +339,19 @@ static esp_err_t esp_lcd_touch_gsl3680_read_data(esp_lcd_touch_handle_t tp)
     uint8_t buf[4] = {0};
 // #endif
 
-    memset(XY_Coordinate,0,sizeof(XY_Coordinate));
+    if (gsl3680_config != NULL && gsl3680_config->max_points != 0 && gsl3680_config->max_points < MAX_FINGER_NUM) {
+        max_points = gsl3680_config->max_points;
+    }
 
-    err = touch_gsl3680_i2c_read(tp, ESP_LCD_TOUCH_GSL3680_READ_XY_REG, touch_data, 24);
-    Finger_num = touch_data[0];
+    /* 0x80 holds the finger count and flags, followed by 4 bytes per finger:
+     * fetch the header first, then only the fingers that are actually down */
+    err = touch_gsl3680_i2c_read(tp, ESP_LCD_TOUCH_GSL3680_READ_XY_REG, touch_data, 4);
+    ESP_RETURN_ON_ERROR(err, TAG, "I2C read error!");
+    touch_cnt = touch_data[0] < max_points ? touch_data[0] : max_points;
+    if (touch_cnt > 0) {
+        err = touch_gsl3680_i2c_read(tp, ESP_LCD_TOUCH_GSL3680_READ_XY_REG + 4, &touch_data[4], touch_cnt * 4);
+        ESP_RETURN_ON_ERROR(err, TAG, "I2C read error!");
+    }
     // ESP_LOGI(TAG,"0x80 = %d",touch_data[0]);
 
     x_poit = ((touch_data[7]&0x0f)<<8 )|touch_data[6];
@@ -330,99 +360,111 @@ static esp_err_t esp_lcd_touch_gsl3680_read_data(esp_lcd_touch_handle_t tp)
 	y2_poit = (touch_data[9]<<8)|touch_data[8];
 
 // #ifdef USE_GSL_NOID_VERSION
-			cinfo.finger_num = Finger_num;	
-			cinfo.x[0] = x_poit;
-			cinfo.y[0] = y_poit;
-			cinfo.id[0] = ((touch_data[7]&0xf0)>>4);
-			cinfo.x[1] = x2_poit;
-			cinfo.y[1] = y2_poit;
-			cinfo.id[1] = ((touch_data[11]&0xf0)>>4);
-			cinfo.finger_num = (touch_data[3]<<24)|(touch_data[2]<<16)|
-				(touch_data[1]<<8)|touch_data[0];
-			
-			gsl_alg_id_main(&cinfo);
-			tmp1=gsl_mask_tiaoping();
-			//SCI_TRACE_LOW("[tp-gsl] tmp1=%x\n", tmp1);
-			if(tmp1>0&&tmp1<0xffffffff)
-			{
-				uint8 addr = 0xf0;
-				buf[0]=0xa;buf[1]=0;buf[2]=0;buf[3]=0;
-				touch_gsl3680_i2c_write(tp,addr, buf, 4);
-				addr = 0x8;
-				buf[0]=(uint8)(tmp1 & 0xff);
-				buf[1]=(uint8)((tmp1>>8) & 0xff);
-				buf[2]=(uint8)((tmp1>>16) & 0xff);
-				buf[3]=(uint8)((tmp1>>24) & 0xff);
-				//SCI_TRACE_LOW("tmp1=%08x,buf[0]=%02x,buf[1]=%02x,buf[2]=%02x,buf[3]=%02x\n", tmp1,buf[0],buf[1],buf[2],buf[3]);
-				touch_gsl3680_i2c_write(tp,addr, buf, 4);
+		/* Nobody touching and nothing pending in the algorithm: it takes its idle
+		 * path and only steps its history */
+		idle = (touch_data[0] | touch_data[1] | touch_data[2] | touch_data[3]) == 0 && gsl_alg_is_idle_ctx(dev->alg);
+		/* The upper header bytes carry flags for the algorithm, the count is what was actually read */
+		gsl_touch_info_from_frame(&cinfo, touch_data, touch_cnt);
+		if (gsl3680_config != NULL && gsl3680_config->lookahead_ms != 0) {
+			/* The algorithm looks ahead in frames, time them while a finger is down */
+			now_us = esp_timer_get_time();
+			if (touch_cnt > 0 && dev->touch_us != 0 && now_us - dev->touch_us < GSL3680_FRAME_GAP_MAX_US) {
+				dev->frame_us = dev->frame_us ? (dev->frame_us * 7 + (uint32_t)(now_us - dev->touch_us)) / 8 : (uint32_t)(now_us - dev->touch_us);
+			}
+			dev->touch_us = touch_cnt > 0 ? now_us : 0;
+			if (dev->frame_us != 0) {
+				gsl_alg_set_lookahead_ctx(dev->alg, gsl3680_config->lookahead_ms * 1000u * 256u / dev->frame_us);
 			}
-			Finger_num = cinfo.finger_num;	
+		}
+		
+		gsl_alg_id_main_ctx(dev->alg, &cinfo);
+		tmp1=gsl_mask_tiaoping_ctx(dev->alg);
+		//SCI_TRACE_LOW("[tp-gsl] tmp1=%x\n", tmp1);
+		if(tmp1>0&&tmp1<0xffffffff)
+		{
+			uint8 addr = 0xf0;
+			buf[0]=0xa;buf[1]=0;buf[2]=0;buf[3]=0;
+			touch_gsl3680_i2c_write(tp,addr, buf, 4);
+			addr = 0x8;
+			buf[0]=(uint8)(tmp1 & 0xff);
+			buf[1]=(uint8)((tmp1>>8) & 0xff);
+			buf[2]=(uint8)((tmp1>>16) & 0xff);
+			buf[3]=(uint8)((tmp1>>24) & 0xff);
+			//SCI_TRACE_LOW("tmp1=%08x,buf[0]=%02x,buf[1]=%02x,buf[2]=%02x,buf[3]=%02x\n", tmp1,buf[0],buf[1],buf[2],buf[3]);
+			touch_gsl3680_i2c_write(tp,addr, buf, 4);
+		}
 // #endif
 
+    portENTER_CRITICAL(&tp->data.lock);
+    dev->read_stats.frames++;
+    gsl_alg_get_delay_stat_ctx(dev->alg, &dev->delay_stat);
+    dev->read_stats.idle_frames += idle;
+    dev->read_stats.bytes_read += 4 + touch_cnt * 4;
+    if (4 + touch_cnt * 4 < ESP_LCD_TOUCH_GSL3680_LEGACY_READ_BYTES) {
+        dev->read_stats.bytes_saved += ESP_LCD_TOUCH_GSL3680_LEGACY_READ_BYTES - (4 + touch_cnt * 4);
+    }
+    memset(dev->XY_Coordinate,0,sizeof(dev->XY_Coordinate));
+    dev->Finger_num = cinfo.finger_num < max_points ? cinfo.finger_num : max_points;
+    for (i = 0; i < dev->Finger_num; i++) {
+        dev->XY_Coordinate[i].x_position = cinfo.x[i];
+        dev->XY_Coordinate[i].y_position = cinfo.y[i];
+        dev->XY_Coordinate[i].finger_id = cinfo.id[i];
+    }
+    portEXIT_CRITICAL(&tp->data.lock);
 
-// #ifdef USE_GSL_NOID_VERSION
-			XY_Coordinate[0].x_position =  cinfo.x[0];
-			XY_Coordinate[0].y_position =  cinfo.y[0];
-			XY_Coordinate[0].finger_id = cinfo.id[0];
-			XY_Coordinate[1].x_position =  cinfo.x[1];
-			XY_Coordinate[1].y_position =  cinfo.y[1];
-			XY_Coordinate[1].finger_id = cinfo.id[1];
-// #else
-// 			XY_Coordinate[0].x_position = x_poit;
-// 			XY_Coordinate[0].y_position = y_poit;
-// 			XY_Coordinate[1].x_position = x2_poit;
-// 			XY_Coordinate[1].y_position = y2_poit;
-// #endif
-    // i=0;
-    // if(Finger_num >0)
-    // printf("%s: %d[i], %d[x_position], %d[y_position], %d[finger_id], %d[finger_num]\n",
-    //       __func__, i, XY_Coordinate[i].x_position, XY_Coordinate[i].y_position, XY_Coordinate[i].finger_id,Finger_num);
-    // i=1;
-    // printf("%s: %d[i], %d[x_position], %d[y_position], %d[finger_id], %d[finger_num]\n",
-    //       __func__, i, XY_Coordinate[i].x_position, XY_Coordinate[i].y_position, XY_Coordinate[i].finger_id,Finger_num);
-    
-    if(Finger_num > 1)
+#ifdef GSL_STAGE_PROFILE
+    if (dev->read_stats.frames % 1000 == 0) {
+        struct gsl_stage_stat stat[32];
+        int count = gsl_stage_profile_ctx(dev->alg, stat, sizeof(stat) / sizeof(stat[0]));
+        size_t n = count > 0 ? (size_t)count : 0;
+        for (i = 0; i < n && i < sizeof(stat) / sizeof(stat[0]); i++) {
+            ESP_LOGI(TAG, "stage %-18s calls %u median %u p99 %u cycles", stat[i].name, stat[i].calls, stat[i].median, stat[i].p99);
+        }
+    }
+#endif
+
+    if(dev->Finger_num > 1)
 	{
-		distance_flag ++;
+		dev->distance_flag ++;
 		distance = (x_poit-x2_poit)*(x_poit-x2_poit) + (y_poit-y2_poit)*(y_poit-y2_poit);
-		chazhi = distance - pre_distance;
-		if(distance_flag >= 3)
+		chazhi = distance - dev->pre_distance;
+		if(dev->distance_flag >= 3)
 		{
 			if( chazhi > 900 )
 			{
-				zoomOutDebounce = 0;
-				zoomInDebounce ++;
-				if(zoomInDebounce > 3)
+				dev->zoomOutDebounce = 0;
+				dev->zoomInDebounce ++;
+				if(dev->zoomInDebounce > 3)
 				{
-					tpc_gesture_id = TG_ZOOM_IN;
-					zoomInDebounce = 0;
+					dev->tpc_gesture_id = TG_ZOOM_IN;
+					dev->zoomInDebounce = 0;
 				}
 			}
 			else if( chazhi < -900 )
 			{
-				zoomInDebounce = 0;
-				zoomOutDebounce ++;
-				if(zoomOutDebounce > 3)
+				dev->zoomInDebounce = 0;
+				dev->zoomOutDebounce ++;
+				if(dev->zoomOutDebounce > 3)
 				{
-					tpc_gesture_id = TG_ZOOM_OUT;
-					zoomOutDebounce = 0;
+					dev->tpc_gesture_id = TG_ZOOM_OUT;
+					dev->zoomOutDebounce = 0;
 				}
 			}
 			else
 			{
-				tpc_gesture_id = TG_NO_DETECT;
+				dev->tpc_gesture_id = TG_NO_DETECT;
 			}
 		}
 
-		pre_distance = distance;
+		dev->pre_distance = distance;
 		}
 	else
 		{
-		tpc_gesture_id = TG_NO_DETECT;
-		distance_flag = 0;
-		pre_distance = 0;
-		zoomInDebounce = 0;
-		zoomOutDebounce = 0;
+		dev->tpc_gesture_id = TG_NO_DETECT;
+		dev->distance_flag = 0;
+		dev->pre_distance = 0;
+		dev->zoomInDebounce = 0;
+		dev->zoomOutDebounce = 0;
 	}
     
     return ESP_OK;
@@ -430,6 +472,8 @@ static esp_err_t esp_lcd_touch_gsl3680_read_data(esp_lcd_touch_handle_t tp)
 
 static bool esp_lcd_touch_gsl3680_get_xy(esp_lcd_touch_handle_t tp, uint16_t *x, uint16_t *y, uint16_t *strength, uint8_t *point_num, uint8_t max_point_num)
 {
+    gsl3680_dev_t *dev = GSL3680_DEV(tp);
+
     assert(tp != NULL);
     assert(x != NULL);
     assert(y != NULL);
@@ -438,20 +482,15 @@ static bool esp_lcd_touch_gsl3680_get_xy(esp_lcd_touch_handle_t tp, uint16_t *x,
 
     portENTER_CRITICAL(&tp->data.lock);
 
-    *point_num = Finger_num;
-    x[0] = XY_Coordinate[0].x_position;
-    y[0] = XY_Coordinate[0].y_position;
-
-    if(Finger_num > 1)
-    {
-        for(int i=1;i<Finger_num;i++)
-        {
-            x[i-1] = XY_Coordinate[i].x_position;
-            y[i-1] = XY_Coordinate[i].y_position;
-            // strength[i] = XY_Coordinate[i].finger_id;
+    *point_num = dev->Finger_num < max_point_num ? dev->Finger_num : max_point_num;
+    for (int i = 0; i < *point_num; i++) {
+        x[i] = dev->XY_Coordinate[i].x_position;
+        y[i] = dev->XY_Coordinate[i].y_position;
+        /* Report the tracking id from the point id algorithm as strength */
+        if (strength) {
+            strength[i] = dev->XY_Coordinate[i].finger_id;
         }
     }
-    
 
     portEXIT_CRITICAL(&tp->data.lock);
 
@@ -483,6 +522,8 @@ static esp_err_t esp_lcd_touch_gsl3680_get_button_state(esp_lcd_touch_handle_t t
 
 static esp_err_t esp_lcd_touch_gsl3680_del(esp_lcd_touch_handle_t tp)
 {
+    gsl3680_dev_t *dev = GSL3680_DEV(tp);
+
     assert(tp != NULL);
 
     /* Reset GPIO pin settings */
@@ -498,119 +539,274 @@ static esp_err_t esp_lcd_touch_gsl3680_del(esp_lcd_touch_handle_t tp)
         gpio_reset_pin(tp->config.rst_gpio_num);
     }
 
-    free(tp);
+    free(dev->alg);
+    free(dev);
 
     return ESP_OK;
 }
 
 /*===================================================================================================================================================================================================*/
-static esp_err_t esp_lcd_touch_gsl3680_init(esp_lcd_touch_handle_t tp)
+esp_err_t esp_lcd_touch_gsl3680_get_boot_info(esp_lcd_touch_handle_t tp, esp_lcd_touch_gsl3680_boot_info_t *info)
 {
-    ESP_LOGI(TAG,"start init");
-    esp_lcd_touch_gsl3680_clear_reg(tp);
-    touch_gsl3680_reset(tp);
-    esp_lcd_touch_gsl3680_load_fw(tp);
-    esp_lcd_touch_gsl3680_startup_chip(tp);
-    touch_gsl3680_reset(tp);
-    esp_lcd_touch_gsl3680_startup_chip(tp);
+    ESP_RETURN_ON_FALSE(tp != NULL && info != NULL, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
 
+    *info = GSL3680_DEV(tp)->boot_info;
     return ESP_OK;
 }
 
+esp_err_t esp_lcd_touch_gsl3680_get_read_stats(esp_lcd_touch_handle_t tp, esp_lcd_touch_gsl3680_read_stats_t *stats)
+{
+    ESP_RETURN_ON_FALSE(tp != NULL && stats != NULL, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    portENTER_CRITICAL(&tp->data.lock);
+    *stats = GSL3680_DEV(tp)->read_stats;
+    portEXIT_CRITICAL(&tp->data.lock);
+    return ESP_OK;
+}
 
-static esp_err_t touch_gsl3680_reset(esp_lcd_touch_handle_t tp)
+esp_err_t esp_lcd_touch_gsl3680_get_delay_stats(esp_lcd_touch_handle_t tp, esp_lcd_touch_gsl3680_delay_stats_t *stats)
 {
-    unsigned char write_buf[4];
-    uint8_t addr;
-    assert(tp != NULL);
+    ESP_RETURN_ON_FALSE(tp != NULL && stats != NULL, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
 
-    ESP_RETURN_ON_ERROR(gpio_set_level(tp->config.rst_gpio_num, 0), TAG, "GPIO set level error!");
-    vTaskDelay(pdMS_TO_TICKS(20));
-    ESP_RETURN_ON_ERROR(gpio_set_level(tp->config.rst_gpio_num, 1), TAG, "GPIO set level error!");
-    vTaskDelay(pdMS_TO_TICKS(20));
+    portENTER_CRITICAL(&tp->data.lock);
+    const struct gsl_delay_stat *st = &GSL3680_DEV(tp)->delay_stat;
+    stats->held = st->held;
+    stats->early = st->early;
+    stats->released = st->released;
+    stats->dropped = st->dropped;
+    stats->unsteady = st->unsteady;
+    stats->noise = st->noise;
+    portEXIT_CRITICAL(&tp->data.lock);
+    return ESP_OK;
+}
 
-    addr = 0xe0;
-    write_buf[0] = 0x88;
-    touch_gsl3680_i2c_write(tp,addr,write_buf,1);
-    vTaskDelay(pdMS_TO_TICKS(10));
-    addr = 0xe4;
-    write_buf[0]=0x04;
-    touch_gsl3680_i2c_write(tp,addr,write_buf,1);
-    vTaskDelay(pdMS_TO_TICKS(10));
+esp_err_t esp_lcd_touch_gsl3680_bringup_poll(esp_lcd_touch_handle_t tp)
+{
+    uint32_t delay_ms = 0;
+    esp_err_t ret;
 
-    write_buf[0] =0x00;
-    write_buf[1] =0x00;
-    write_buf[2] =0x00;
-    write_buf[3] =0x00;
-    touch_gsl3680_i2c_write(tp,0xbc,write_buf,4);
+    ESP_RETURN_ON_FALSE(tp != NULL, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    gsl3680_dev_t *dev = GSL3680_DEV(tp);
 
-    vTaskDelay(pdMS_TO_TICKS(10));
+    if (dev->bringup.stage == GSL_BRINGUP_READY) {
+        return ESP_OK;
+    }
+    if (dev->bringup.stage == GSL_BRINGUP_FAILED) {
+        return dev->bringup.result;
+    }
+    if (esp_timer_get_time() < dev->bringup.wake_us) {
+        return ESP_ERR_NOT_FINISHED;
+    }
 
-    return ESP_OK;
+    ret = touch_gsl3680_bringup_stage(tp, &delay_ms);
+    if (ret != ESP_ERR_NOT_FINISHED) {
+        touch_gsl3680_bringup_next(tp, ret);
+    }
+    dev->bringup.wake_us = esp_timer_get_time() + (int64_t)delay_ms * 1000;
+
+    if (dev->bringup.stage == GSL_BRINGUP_READY) {
+        ESP_LOGI(TAG,"gsl3680 ready");
+        return ESP_OK;
+    }
+    if (dev->bringup.stage == GSL_BRINGUP_FAILED) {
+        dev->bringup.result = ret;
+        return ret;
+    }
+    return ESP_ERR_NOT_FINISHED;
 }
 
-static esp_err_t touch_gsl3680_read_cfg(esp_lcd_touch_handle_t tp)
+/* Run one step of the current stage; ESP_ERR_NOT_FINISHED means the stage has more steps */
+static esp_err_t touch_gsl3680_bringup_stage(esp_lcd_touch_handle_t tp, uint32_t *delay_ms)
 {
-    uint8_t buf[4];
-    uint8_t write[4];
-    uint8_t i2c_buffer_read = 0;
-    uint8_t i2c_buffer_write = 0x12;
-    esp_err_t ret = ESP_OK;
+    gsl3680_dev_t *dev = GSL3680_DEV(tp);
 
-    write[0] = 0x12;
-    write[1] = 0x34;
-    write[2] = 0x56;
-    assert(tp != NULL);
+    switch (dev->bringup.stage) {
+    case GSL_BRINGUP_POWER_ON:
+        if (tp->config.rst_gpio_num != GPIO_NUM_NC && tp->config.int_gpio_num != GPIO_NUM_NC) {
+            return touch_gsl3680_run_step(tp, GSL_SCRIPT(gsl3680_power_on_script), delay_ms);
+        }
+        return touch_gsl3680_run_step(tp, GSL_SCRIPT(gsl3680_reset_script), delay_ms);
+    case GSL_BRINGUP_READ_CFG:
+        return touch_gsl3680_run_step(tp, GSL_SCRIPT(gsl3680_read_cfg_script), delay_ms);
+    case GSL_BRINGUP_CHECK_RESET:
+    case GSL_BRINGUP_RESET:
+    case GSL_BRINGUP_RESET_AGAIN:
+        return touch_gsl3680_run_step(tp, GSL_SCRIPT(gsl3680_reset_script), delay_ms);
+    case GSL_BRINGUP_CHECK_SIG:
+        return esp_lcd_touch_gsl3680_check_sig(tp);
+    case GSL_BRINGUP_CHECK_STARTUP:
+    case GSL_BRINGUP_STARTUP:
+    case GSL_BRINGUP_STARTUP_AGAIN:
+        return touch_gsl3680_run_step(tp, GSL_SCRIPT(gsl3680_startup_script), delay_ms);
+    case GSL_BRINGUP_CHECK_RUN:
+    case GSL_BRINGUP_VERIFY:
+        return touch_gsl3680_run_step(tp, GSL_SCRIPT(gsl3680_read_ram_fw_script), delay_ms);
+    case GSL_BRINGUP_CLEAR_REG:
+        return touch_gsl3680_run_step(tp, GSL_SCRIPT(gsl3680_clear_reg_script), delay_ms);
+    case GSL_BRINGUP_LOAD_FW:
+        return esp_lcd_touch_gsl3680_load_fw(tp, &dev->bringup.fw, ESP_LCD_TOUCH_GSL3680_BRINGUP_SLICE_US);
+    case GSL_BRINGUP_INT_SETUP:
+        return touch_gsl3680_int_setup(tp);
+    default:
+        return ESP_ERR_INVALID_STATE;
+    }
+}
 
-    ESP_LOGI(TAG,"gsl3680 connect");
+/* Pick the stage after the one that just finished with ret */
+static void touch_gsl3680_bringup_next(esp_lcd_touch_handle_t tp, esp_err_t ret)
+{
+    gsl3680_dev_t *dev = GSL3680_DEV(tp);
+    const esp_lcd_touch_io_gsl3680_config_t *gsl3680_config = tp->config.driver_data;
+    const int64_t now = esp_timer_get_time();
+
+    dev->bringup.step = 0;
+    switch (dev->bringup.stage) {
+    case GSL_BRINGUP_READ_CFG:
+        dev->bringup.stage_us = now;
+        if (gsl3680_config != NULL && gsl3680_config->fw_sig_digest != 0 && gsl3680_config->fw_sig_words != 0) {
+            dev->bringup.stage = GSL_BRINGUP_CHECK_RESET;
+        } else {
+            dev->bringup.stage = GSL_BRINGUP_CLEAR_REG;
+        }
+        return;
+    case GSL_BRINGUP_CHECK_RESET:
+    case GSL_BRINGUP_CHECK_SIG:
+    case GSL_BRINGUP_CHECK_STARTUP:
+    case GSL_BRINGUP_CHECK_RUN:
+        if (ret == ESP_OK && dev->bringup.stage != GSL_BRINGUP_CHECK_RUN) {
+            dev->bringup.stage++;
+            return;
+        }
+        dev->boot_info.fw_verify_us = (uint32_t)(now - dev->bringup.stage_us);
+        if (ret == ESP_OK) {
+            dev->boot_info.fw_reused = true;
+            ESP_LOGI(TAG,"firmware already resident, upload skipped (%u us)", (unsigned)dev->boot_info.fw_verify_us);
+            dev->bringup.stage = GSL_BRINGUP_VERIFY;
+            return;
+        }
+        dev->bringup.stage_us = now;
+        dev->bringup.stage = GSL_BRINGUP_CLEAR_REG;
+        return;
+    case GSL_BRINGUP_RESET:
+        memset(&dev->bringup.fw, 0, sizeof(dev->bringup.fw));
+        dev->bringup.fw.page = -1;
+        dev->bringup.stage = GSL_BRINGUP_LOAD_FW;
+        return;
+    case GSL_BRINGUP_STARTUP_AGAIN:
+        dev->boot_info.fw_load_us = (uint32_t)(now - dev->bringup.stage_us);
+        ESP_LOGI(TAG,"firmware uploaded (%u us)", (unsigned)dev->boot_info.fw_load_us);
+        dev->bringup.stage = GSL_BRINGUP_VERIFY;
+        return;
+    case GSL_BRINGUP_VERIFY:
+    case GSL_BRINGUP_INT_SETUP:
+        dev->bringup.stage = ret == ESP_OK ? dev->bringup.stage + 1 : GSL_BRINGUP_FAILED;
+        return;
+    default:
+        /* The rest of the cold sequence is best effort, only the final 0xb0 check decides */
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG,"bring-up stage %d failed (0x%x), continuing", dev->bringup.stage, ret);
+        }
+        dev->bringup.stage++;
+        return;
+    }
+}
 
-    ESP_RETURN_ON_ERROR(touch_gsl3680_i2c_read(tp, 0xf0, (uint8_t *)&buf, 4), TAG, "gsl3680 read error!");
-    ESP_LOGI(TAG,"gsl3680 read reg 0xf0 before is %x %x %x %x",buf[0],buf[1],buf[2],buf[3]);
-    vTaskDelay(pdMS_TO_TICKS(20));
-    ESP_LOGI(TAG,"gsl3680 writing 0xf0 0x12");
-    ESP_RETURN_ON_ERROR(touch_gsl3680_i2c_write(tp,0xf0,write,4),TAG,"gsl3680 read error");
-    vTaskDelay(pdMS_TO_TICKS(20));
-    ESP_RETURN_ON_ERROR(touch_gsl3680_i2c_read(tp, 0xf0, (uint8_t *)&buf, 4), TAG, "gsl3680 read error!");
-    ESP_LOGI(TAG,"gsl3680 read reg 0xf0 after is %x %x %x %x",buf[0],buf[1],buf[2],buf[3]);
+static esp_err_t touch_gsl3680_run_step(esp_lcd_touch_handle_t tp, const gsl3680_step_t *script, size_t len, uint32_t *delay_ms)
+{
+    gsl3680_dev_t *dev = GSL3680_DEV(tp);
+    const esp_lcd_touch_io_gsl3680_config_t *gsl3680_config = tp->config.driver_data;
+    const gsl3680_step_t *step = &script[dev->bringup.step++];
+    uint8_t buf[4];
+    esp_err_t ret = ESP_OK;
 
-    if(i2c_buffer_read == i2c_buffer_write)
-    {
-        ret = ESP_OK;
-        ESP_LOGI(TAG,"read cfg success");
+    switch (step->op) {
+    case GSL_OP_WAIT:
+        break;
+    case GSL_OP_RST:
+        ret = gpio_set_level(tp->config.rst_gpio_num, step->data[0]);
+        break;
+    case GSL_OP_RST_CFG:
+        ret = gpio_set_level(tp->config.rst_gpio_num, step->data[0] ? tp->config.levels.reset : !tp->config.levels.reset);
+        break;
+    case GSL_OP_INT:
+        ret = gpio_set_level(tp->config.int_gpio_num, step->data[0]);
+        break;
+    case GSL_OP_WRITE:
+        ret = touch_gsl3680_i2c_write(tp, step->reg, step->data, step->len);
+        break;
+    case GSL_OP_DUMP:
+        ret = touch_gsl3680_i2c_read(tp, step->reg, buf, sizeof(buf));
+        if (ret == ESP_OK) {
+            ESP_LOGI(TAG,"gsl3680 read reg 0x%02x is %x %x %x %x", step->reg, buf[0], buf[1], buf[2], buf[3]);
+        }
+        break;
+    case GSL_OP_CHECK_RUN:
+        ret = touch_gsl3680_i2c_read(tp, step->reg, buf, sizeof(buf));
+        if (ret == ESP_OK && memcmp(buf, step->data, sizeof(buf)) != 0) {
+            ESP_LOGI(TAG,"gsl3680 startup_chip failed read 0x%02x = %x,%x,%x,%x ", step->reg, buf[3], buf[2], buf[1], buf[0]);
+            ret = ESP_FAIL;
+        }
+        break;
+    case GSL_OP_DATA_INIT:
+        gsl_DataInit_ctx(dev->alg, gsl_config_data_id);
+        gsl_alg_set_adaptive_delay_ctx(dev->alg, gsl3680_config != NULL && gsl3680_config->adaptive_delay);
+        break;
+    default:
+        ret = ESP_ERR_INVALID_ARG;
+        break;
     }
-    else 
-        ret = ESP_FAIL;
+    *delay_ms = step->delay_ms;
 
-    return ret;
+    ESP_RETURN_ON_ERROR(ret, TAG, "bring-up step %u of stage %d failed", (unsigned)(dev->bringup.step - 1), dev->bringup.stage);
+    return dev->bringup.step < len ? ESP_ERR_NOT_FINISHED : ESP_OK;
 }
 
-static esp_err_t esp_lcd_touch_gsl3680_startup_chip(esp_lcd_touch_handle_t tp)
+/* Warm start: after a soft reset of the host the controller may still be powered
+ * and running the firmware. With its core halted, compare the signature words with
+ * the digest computed by firmware.py; the following startup and 0xb0 run check
+ * must pass as well before the upload is skipped. */
+static esp_err_t esp_lcd_touch_gsl3680_check_sig(esp_lcd_touch_handle_t tp)
 {
-    esp_err_t ret = ESP_OK;
-    uint8_t write_buf[4];
-    uint8_t addr = 0xe0;
-    write_buf[0] = 0x00;
-    ESP_LOGI(TAG,"enter");
-    ESP_RETURN_ON_ERROR(touch_gsl3680_i2c_write(tp,addr,write_buf,1),TAG,"gsl3680 read error");
-    vTaskDelay(pdMS_TO_TICKS(10));
-
-    gsl_DataInit(gsl_config_data_id);
-    return ret;
+    const esp_lcd_touch_io_gsl3680_config_t *gsl3680_config = tp->config.driver_data;
+    uint8_t buf[ESP_LCD_TOUCH_GSL3680_FW_BURST_WORDS_MAX * 4];
+    /* unsigned fields, widened before the sum so it cannot wrap */
+    const size_t start = gsl3680_config->fw_sig_start;
+    const size_t len = (size_t)gsl3680_config->fw_sig_words * 4;
+    uint32_t digest = 0x811c9dc5;
+
+    ESP_RETURN_ON_FALSE(start + len <= sizeof(buf), ESP_ERR_INVALID_ARG, TAG, "bad firmware signature range");
+
+    buf[0] = gsl3680_config->fw_sig_page;
+    ESP_RETURN_ON_ERROR(touch_gsl3680_i2c_write(tp, 0xf0, buf, 1), TAG, "page select failed");
+    ESP_RETURN_ON_ERROR(touch_gsl3680_i2c_read(tp, gsl3680_config->fw_sig_start, buf, len), TAG, "signature read failed");
+    for (size_t i = 0; i < len; i++) {
+        digest = (digest ^ buf[i]) * 0x01000193;
+    }
+    if (digest != gsl3680_config->fw_sig_digest) {
+        ESP_LOGI(TAG,"firmware signature 0x%08x, expected 0x%08x", (unsigned)digest, (unsigned)gsl3680_config->fw_sig_digest);
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    return ESP_OK;
 }
 
-static esp_err_t esp_lcd_touch_gsl3680_read_ram_fw(esp_lcd_touch_handle_t tp)
+static esp_err_t touch_gsl3680_int_setup(esp_lcd_touch_handle_t tp)
 {
-    uint8_t read_buf[4];
-    uint8_t addr = 0xb0;
-    ESP_LOGI(TAG,"enter read_ram_fw");
-    vTaskDelay(pdMS_TO_TICKS(30));
-    ESP_RETURN_ON_ERROR(touch_gsl3680_i2c_read(tp, addr, (uint8_t *)&read_buf, 4), TAG, "gsl3680 read error!");
-    ESP_LOGI(TAG,"gsl3680 startup_chip failed read 0xb0 = %x,%x,%x,%x ",read_buf[3],read_buf[2],read_buf[1],read_buf[0]);
-    if(read_buf[3] != 0x5a || read_buf[2] != 0x5a || read_buf[1] != 0x5a || read_buf[0] != 0x5a)
-    {
-         
-        return ESP_FAIL;
+    /* Prepare pin for touch interrupt */
+    if (tp->config.int_gpio_num != GPIO_NUM_NC) {
+        const gpio_config_t int_gpio_config = {
+            .mode = GPIO_MODE_INPUT,
+            .intr_type = (tp->config.levels.interrupt ? GPIO_INTR_POSEDGE : GPIO_INTR_NEGEDGE),
+            .pin_bit_mask = BIT64(tp->config.int_gpio_num)
+        };
+        ESP_RETURN_ON_ERROR(gpio_config(&int_gpio_config), TAG, "GPIO config failed");
+
+        /* Register interrupt callback */
+        if (tp->config.interrupt_callback) {
+            esp_lcd_touch_register_interrupt_callback(tp, tp->config.interrupt_callback);
+        }
     }
+
     return ESP_OK;
 }
 
@@ -625,7 +821,7 @@ static esp_err_t touch_gsl3680_i2c_read(esp_lcd_touch_handle_t tp, uint16_t reg,
   
 }
 
-static esp_err_t touch_gsl3680_i2c_write(esp_lcd_touch_handle_t tp, uint16_t reg, uint8_t *data,uint8_t len)
+static esp_err_t touch_gsl3680_i2c_write(esp_lcd_touch_handle_t tp, uint16_t reg, const uint8_t *data,uint8_t len)
 {
     assert(tp != NULL);
 
@@ -635,122 +831,189 @@ static esp_err_t touch_gsl3680_i2c_write(esp_lcd_touch_handle_t tp, uint16_t reg
     // // *INDENT-ON*
 }
 
-static esp_err_t esp_lcd_touch_gsl3680_load_fw(esp_lcd_touch_handle_t tp)
+/* Upload firmware until it is complete or budget_us has been spent; returns
+ * ESP_ERR_NOT_FINISHED with fw positioned at the next write in the latter case. */
+static esp_err_t esp_lcd_touch_gsl3680_load_fw(esp_lcd_touch_handle_t tp, gsl3680_fw_cursor_t *fw, uint32_t budget_us)
 {
-    ESP_LOGI(TAG,"start load fw");
-    uint16_t addr;
-    unsigned char wrbuf[4];
-    uint16_t source_line = 0;
-    uint16_t source_len = sizeof(GSLX680_FW) / sizeof(struct fw_data);
-
-    for(source_line=0;source_line<source_len;source_line++)
-    {
-        addr = GSLX680_FW[source_line].offset;
-        wrbuf[0] = (uint8_t)(GSLX680_FW[source_line].val & 0x000000ff);
-        wrbuf[1] = (uint8_t)((GSLX680_FW[source_line].val & 0x0000ff00) >> 8);
-        wrbuf[2] = (uint8_t)((GSLX680_FW[source_line].val & 0x00ff0000) >> 16);
-        wrbuf[3] = (uint8_t)((GSLX680_FW[source_line].val & 0xff000000) >> 24);
-        if(addr == 0xf0)
-            touch_gsl3680_i2c_write(tp,addr,wrbuf,1);
-        else
-            touch_gsl3680_i2c_write(tp,addr,wrbuf,4);
-        
-    }
-    ESP_LOGI(TAG,"load fw success");
-    return ESP_OK;
+    const esp_lcd_touch_io_gsl3680_config_t *gsl3680_config = tp->config.driver_data;
+    const int64_t start = esp_timer_get_time();
+    size_t burst = ESP_LCD_TOUCH_GSL3680_FW_BURST_WORDS_DEFAULT;
+    esp_err_t ret;
+
+    if (gsl3680_config != NULL && gsl3680_config->fw_burst_words != 0) {
+        burst = gsl3680_config->fw_burst_words;
+    }
+    if (burst > ESP_LCD_TOUCH_GSL3680_FW_BURST_WORDS_MAX) {
+        burst = ESP_LCD_TOUCH_GSL3680_FW_BURST_WORDS_MAX;
+    }
+    if (fw->writes == 0) {
+        ESP_LOGI(TAG,"start load fw");
+    }
+
+    do {
+        if (gsl3680_config != NULL && gsl3680_config->fw_blob != NULL) {
+            ret = esp_lcd_touch_gsl3680_load_fw_packed(tp, fw, gsl3680_config->fw_blob, gsl3680_config->fw_blob_len, burst);
+        } else {
+#ifndef ESP_LCD_TOUCH_GSL3680_PACKED_FW
+            ret = esp_lcd_touch_gsl3680_load_fw_table(tp, fw, burst);
+#else
+            ESP_LOGE(TAG, "no firmware: build uses the packed image but none was configured");
+            return ESP_ERR_NOT_FOUND;
+#endif
+        }
+    } while (ret == ESP_ERR_NOT_FINISHED && esp_timer_get_time() - start < budget_us);
+
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG,"load fw success, %u words in %u writes", (unsigned)fw->words, (unsigned)fw->writes);
+    }
+    return ret;
+}
+
+/* Send the next write of the packed image, ESP_OK once the whole image is out */
+static esp_err_t esp_lcd_touch_gsl3680_load_fw_packed(esp_lcd_touch_handle_t tp, gsl3680_fw_cursor_t *fw, const uint8_t *blob, size_t len, size_t burst)
+{
+    if (fw->pos >= len) {
+        return ESP_OK;
+    }
+
+    /* Segments are [page, start, count, count * 4 little-endian bytes]; the
+     * payload already has the controller byte order and is written in place. */
+    ESP_RETURN_ON_FALSE(fw->pos + 3 <= len, ESP_ERR_INVALID_SIZE, TAG, "packed fw truncated at %u", (unsigned)fw->pos);
+    const uint8_t *seg = &blob[fw->pos];
+    const uint8_t start = seg[1];
+    const size_t count = seg[2];
+    ESP_RETURN_ON_FALSE(count != 0 && start + count * 4 <= ESP_LCD_TOUCH_GSL3680_FW_BURST_WORDS_MAX * 4 && fw->pos + 3 + count * 4 <= len,
+                        ESP_ERR_INVALID_SIZE, TAG, "packed fw segment at %u is corrupt", (unsigned)fw->pos);
+
+    if (seg[0] != fw->page) {
+        ESP_RETURN_ON_ERROR(touch_gsl3680_i2c_write(tp, 0xf0, &seg[0], 1), TAG, "load fw page select failed");
+        fw->page = seg[0];
+        fw->writes++;
+        return ESP_ERR_NOT_FINISHED;
+    }
+
+    const size_t n = (count - fw->done) < burst ? (count - fw->done) : burst;
+    ESP_RETURN_ON_ERROR(touch_gsl3680_i2c_write(tp, start + fw->done * 4, &seg[3 + fw->done * 4], n * 4), TAG, "load fw failed at 0x%02x", (unsigned)(start + fw->done * 4));
+    fw->done += n;
+    fw->words += n;
+    fw->writes++;
+    if (fw->done == count) {
+        fw->pos += 3 + count * 4;
+        fw->done = 0;
+    }
+    return fw->pos < len ? ESP_ERR_NOT_FINISHED : ESP_OK;
 }
 
-static esp_err_t esp_lcd_touch_gsl3680_clear_reg(esp_lcd_touch_handle_t tp)
+#ifndef ESP_LCD_TOUCH_GSL3680_PACKED_FW
+/* Send the next write of GSLX680_FW, ESP_OK once the whole table is out */
+static esp_err_t esp_lcd_touch_gsl3680_load_fw_table(esp_lcd_touch_handle_t tp, gsl3680_fw_cursor_t *fw, size_t burst)
 {
+    const size_t source_len = sizeof(GSLX680_FW) / sizeof(struct fw_data);
+    uint8_t wrbuf[ESP_LCD_TOUCH_GSL3680_FW_BURST_WORDS_MAX * 4];
     uint8_t addr;
-    uint8_t wrbuf[4];
+    uint8_t start;
+    size_t words = 0;
 
-    ESP_LOGI(TAG,"clear reg");
-    addr = 0xe0;
-    wrbuf[0] = 0x88;
-    touch_gsl3680_i2c_write(tp,addr,wrbuf,1);
-    vTaskDelay(pdMS_TO_TICKS(20));
-    addr = 0x88;
-    wrbuf[0] = 0x01;
-    touch_gsl3680_i2c_write(tp,addr,wrbuf,1);
-    vTaskDelay(pdMS_TO_TICKS(5));
-    addr = 0xe4;
-    wrbuf[0] = 0x04;
-    touch_gsl3680_i2c_write(tp,addr,wrbuf,1);
-    vTaskDelay(pdMS_TO_TICKS(5));
-    addr = 0xe0;
-    wrbuf[0] = 0x00;
-    touch_gsl3680_i2c_write(tp,addr,wrbuf,1);
-    vTaskDelay(pdMS_TO_TICKS(20));
+    if (fw->pos >= source_len) {
+        return ESP_OK;
+    }
 
-    return ESP_OK;
+    addr = (uint8_t)GSLX680_FW[fw->pos].offset;
+    if (addr == 0xf0) {
+        wrbuf[0] = (uint8_t)(GSLX680_FW[fw->pos].val & 0x000000ff);
+        ESP_RETURN_ON_ERROR(touch_gsl3680_i2c_write(tp, addr, wrbuf, 1), TAG, "load fw page select failed");
+        fw->pos++;
+        fw->writes++;
+        return fw->pos < source_len ? ESP_ERR_NOT_FINISHED : ESP_OK;
+    }
+
+    /* Words with consecutive offsets inside one 0xf0 page are sent as a single
+     * auto-incrementing write; a page select always closes the run. */
+    start = addr;
+    while (fw->pos < source_len && words < burst) {
+        addr = (uint8_t)GSLX680_FW[fw->pos].offset;
+        if (addr == 0xf0 || addr != start + words * 4) {
+            break;
+        }
+        wrbuf[words * 4 + 0] = (uint8_t)(GSLX680_FW[fw->pos].val & 0x000000ff);
+        wrbuf[words * 4 + 1] = (uint8_t)((GSLX680_FW[fw->pos].val & 0x0000ff00) >> 8);
+        wrbuf[words * 4 + 2] = (uint8_t)((GSLX680_FW[fw->pos].val & 0x00ff0000) >> 16);
+        wrbuf[words * 4 + 3] = (uint8_t)((GSLX680_FW[fw->pos].val & 0xff000000) >> 24);
+        words++;
+        fw->pos++;
+    }
+    ESP_RETURN_ON_ERROR(touch_gsl3680_i2c_write(tp, start, wrbuf, words * 4), TAG, "load fw failed at 0x%02x", start);
+    fw->words += words;
+    fw->writes++;
+    return fw->pos < source_len ? ESP_ERR_NOT_FINISHED : ESP_OK;
 }
+#endif
 
-static TP_STATE_E _Get_Cal_msg(void)
+static TP_STATE_E _Get_Cal_msg(gsl3680_dev_t *dev)
 {
     uint8 pen_flag = 0;
 	uint16 x_poit, y_poit, x2_poit, y2_poit;
 	int32 x_delta = 0 , y_delta = 0;
 
-	pen_flag = Finger_num;
-	x_poit = XY_Coordinate[0].x_position;
-	y_poit = XY_Coordinate[0].y_position;
-	x2_poit = XY_Coordinate[1].x_position;
-	y2_poit = XY_Coordinate[1].y_position;
+	pen_flag = dev->Finger_num;
+	x_poit = dev->XY_Coordinate[0].x_position;
+	y_poit = dev->XY_Coordinate[0].y_position;
+	x2_poit = dev->XY_Coordinate[1].x_position;
+	y2_poit = dev->XY_Coordinate[1].y_position;
 
 	if(pen_flag==0)
 	{
-		if(tp_event == TP_PEN_MOVE)//the last event=move
+		if(dev->tp_event == TP_PEN_MOVE)//the last event=move
 		{
-			x_new = x_poit;
-			y_new = y_poit;
+			dev->x_new = x_poit;
+			dev->y_new = y_poit;
 		}
 		else//the last event=down
 		{
-			x_new = x_start;
-			y_new = y_start;
+			dev->x_new = dev->x_start;
+			dev->y_new = dev->y_start;
 		}
 
-		tp_event = TP_PEN_UP;
+		dev->tp_event = TP_PEN_UP;
 	}
 	else if(pen_flag==2)
 	{
-		tp_event = TP_PEN_DOWN;
-		x_start = x_poit;
-		y_start = y_poit;
-		x_new = x_poit;
-		y_new = y_poit;
+		dev->tp_event = TP_PEN_DOWN;
+		dev->x_start = x_poit;
+		dev->y_start = y_poit;
+		dev->x_new = x_poit;
+		dev->y_new = y_poit;
 	}
-	else if(pre_pen_flag!=1)//pen_flag=1,pre_pen_flag==0 or 2
+	else if(dev->pre_pen_flag!=1)//pen_flag=1,pre_pen_flag==0 or 2
 	{
-		tp_event = TP_PEN_DOWN;
-		x_start = x_poit;
-		y_start = y_poit;
-		x_new = x_poit;
-		y_new = y_poit;
+		dev->tp_event = TP_PEN_DOWN;
+		dev->x_start = x_poit;
+		dev->y_start = y_poit;
+		dev->x_new = x_poit;
+		dev->y_new = y_poit;
 	 }
 	else// if((pen_flag==1)&&(pre_pen_flag==1))
 	{
-		x_delta = x_poit - x_start;
-		y_delta = y_poit - y_start;
+		x_delta = x_poit - dev->x_start;
+		y_delta = y_poit - dev->y_start;
 		if((x_delta>20)||(x_delta<-20)||(y_delta>25)||(y_delta<-25))
 		{
-			tp_event = TP_PEN_MOVE;
+			dev->tp_event = TP_PEN_MOVE;
 		}
 
-		if(tp_event == TP_PEN_MOVE)
+		if(dev->tp_event == TP_PEN_MOVE)
 		{
-			x_new = x_poit;
-			y_new = y_poit;
+			dev->x_new = x_poit;
+			dev->y_new = y_poit;
 		}
 		else
 		{
-			x_new = x_start;
-			y_new = y_start;
+			dev->x_new = dev->x_start;
+			dev->y_new = dev->y_start;
 		}
 
 	 }
 
-	pre_pen_flag = pen_flag;
-	return tp_event;
+	dev->pre_pen_flag = pen_flag;
+	return dev->tp_event;
 }
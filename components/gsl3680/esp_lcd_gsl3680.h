@@ -4,7 +4,7 @@
 #include "esp_lcd_touch.h"
 
 
-#define MAX_FINGER_NUM      3
+#define MAX_FINGER_NUM      10
 #define TP_MULTI_SUCCESS    0
 
 #define TP_PEN_NONE         0
@@ -59,12 +59,93 @@ typedef struct _TPDSVR_SIG_T{
 
 esp_err_t esp_lcd_touch_new_i2c_gsl3680(esp_lcd_panel_io_handle_t io, const esp_lcd_touch_config_t *config, esp_lcd_touch_handle_t *out_touch);
 
+/**
+ * @brief Create a GSL3680 handle without running the controller bring-up
+ *
+ * The reset, firmware upload and startup sequence is then advanced by
+ * esp_lcd_touch_gsl3680_bringup_poll(). The handle must not be read before
+ * the poll has returned ESP_OK.
+ *
+ */
+esp_err_t esp_lcd_touch_new_i2c_gsl3680_async(esp_lcd_panel_io_handle_t io, const esp_lcd_touch_config_t *config, esp_lcd_touch_handle_t *out_touch);
+
+/**
+ * @brief Run the next due bring-up step, never sleeps
+ *
+ * @return ESP_ERR_NOT_FINISHED while the bring-up is in progress, ESP_OK once the
+ *         controller is running, any other code if it failed to start
+ *
+ */
+esp_err_t esp_lcd_touch_gsl3680_bringup_poll(esp_lcd_touch_handle_t tp);
+
 #define ESP_LCD_TOUCH_IO_I2C_GSL3680_ADDRESS          (0x40)
 
+/* Firmware upload: longest run of consecutive words sent in one I2C write (one 0xf0 page holds 32) */
+#define ESP_LCD_TOUCH_GSL3680_FW_BURST_WORDS_MAX      (32)
+#define ESP_LCD_TOUCH_GSL3680_FW_BURST_WORDS_DEFAULT  (8)
+
+/* Polled bring-up: longest time one poll spends uploading firmware */
+#ifndef ESP_LCD_TOUCH_GSL3680_BRINGUP_SLICE_US
+#define ESP_LCD_TOUCH_GSL3680_BRINGUP_SLICE_US        (4000)
+#endif
+
 typedef struct {
-    uint8_t dev_addr;  /*!< I2C device address */
+    uint8_t dev_addr;        /*!< I2C device address */
+    uint8_t fw_burst_words;  /*!< Max words per firmware write, 1 = one write per word, 0 = default */
+    const uint8_t *fw_blob;  /*!< Packed firmware generated by firmware.py, NULL = use GSLX680_FW */
+    size_t fw_blob_len;      /*!< Size of fw_blob in bytes */
+    uint32_t fw_sig_digest;  /*!< FNV-1a of the firmware signature words (firmware.py), 0 = always upload */
+    uint8_t fw_sig_page;     /*!< Page holding the signature words */
+    uint8_t fw_sig_start;    /*!< Register offset of the first signature word */
+    uint8_t fw_sig_words;    /*!< Number of signature words */
+    uint8_t max_points;      /*!< Fingers read per frame, 0 = MAX_FINGER_NUM */
+    uint16_t lookahead_ms;   /*!< Report each finger this far ahead along its motion, at most 4 frames, 0 = off */
+    bool adaptive_delay;     /*!< Report a new finger once it has settled instead of after the configured delay */
 } esp_lcd_touch_io_gsl3680_config_t;
 
+/**
+ * @brief Outcome of the last controller bring-up
+ *
+ */
+typedef struct {
+    bool fw_reused;          /*!< Controller RAM already held this firmware, upload skipped */
+    uint32_t fw_verify_us;   /*!< Time spent checking the resident firmware */
+    uint32_t fw_load_us;     /*!< Time spent on the cold init sequence, 0 when the firmware was reused */
+} esp_lcd_touch_gsl3680_boot_info_t;
+
+esp_err_t esp_lcd_touch_gsl3680_get_boot_info(esp_lcd_touch_handle_t tp, esp_lcd_touch_gsl3680_boot_info_t *info);
+
+/* Size of the fixed coordinate read used before the header-first read, baseline for bytes_saved */
+#define ESP_LCD_TOUCH_GSL3680_LEGACY_READ_BYTES       (24)
+
+/**
+ * @brief Coordinate read counters since the handle was created
+ *
+ */
+typedef struct {
+    uint32_t frames;         /*!< Coordinate reads */
+    uint32_t idle_frames;    /*!< Reads that found no finger and took the idle path of the point id algorithm */
+    uint32_t bytes_read;     /*!< Bytes read from the coordinate registers */
+    uint32_t bytes_saved;    /*!< Bytes not read compared with the fixed 24-byte read */
+} esp_lcd_touch_gsl3680_read_stats_t;
+
+esp_err_t esp_lcd_touch_gsl3680_get_read_stats(esp_lcd_touch_handle_t tp, esp_lcd_touch_gsl3680_read_stats_t *stats);
+
+/**
+ * @brief Report delay decisions of the point id algorithm on new fingers
+ *
+ */
+typedef struct {
+    uint32_t held;           /*!< Frames a new finger was held back */
+    uint32_t early;          /*!< Fingers released once settled, adaptive_delay only */
+    uint32_t released;       /*!< Fingers released after the configured delay */
+    uint32_t dropped;        /*!< Fingers lifted while held, never reported */
+    uint32_t unsteady;       /*!< Held frames across a change of the scan interval, adaptive_delay only */
+    uint32_t noise;          /*!< Step noise of reported fingers in 1/16 coordinate units, adaptive_delay only */
+} esp_lcd_touch_gsl3680_delay_stats_t;
+
+esp_err_t esp_lcd_touch_gsl3680_get_delay_stats(esp_lcd_touch_handle_t tp, esp_lcd_touch_gsl3680_delay_stats_t *stats);
+
 struct fw_data
 {
 	char offset;
@@ -92,6 +173,8 @@ struct fw_data
 }
 #endif
 
+/* Builds that ship the packed blob from firmware.py define this to drop the padded table from flash */
+#ifndef ESP_LCD_TOUCH_GSL3680_PACKED_FW
 static const struct fw_data GSLX680_FW[] = {
 
 {0xf0,0x2},
@@ -4689,6 +4772,7 @@ static const struct fw_data GSLX680_FW[] = {
 
 
 };
+#endif
 
 
 
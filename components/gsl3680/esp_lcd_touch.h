@@ -24,7 +24,7 @@ extern "C" {
 #endif
 
 #define CONFIG_ESP_LCD_TOUCH_MAX_BUTTONS     (1)
-#define CONFIG_ESP_LCD_TOUCH_MAX_POINTS     (5)
+#define CONFIG_ESP_LCD_TOUCH_MAX_POINTS     (10)
 
 /**
  * @brief Touch controller type
@@ -65,6 +65,8 @@ typedef struct {
     void (*process_coordinates)(esp_lcd_touch_handle_t tp, uint16_t *x, uint16_t *y, uint16_t *strength, uint8_t *point_num, uint8_t max_point_num);
     /*!< User callback called after the touch interrupt occured */
     esp_lcd_touch_interrupt_callback_t interrupt_callback;
+    /*!< Controller specific configuration, owned by the caller */
+    void *driver_data;
 } esp_lcd_touch_config_t;
 
 typedef struct {
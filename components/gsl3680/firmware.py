@@ -0,0 +1,83 @@
+"""Build-time conversion of the GSLX680_FW table into a packed page-segmented blob.
+
+Blob layout, one segment after the other until the end of the data:
+
+    uint8  page    value written to register 0xf0 before the segment
+    uint8  start   register offset of the first word
+    uint8  count   number of 32-bit words (1..32)
+    uint8  data[count * 4]  little-endian words, sent to the controller as-is
+"""
+
+from pathlib import Path
+import re
+
+FW_HEADER = Path(__file__).parent / "esp_lcd_gsl3680.h"
+
+PAGE_REG = 0xF0
+WORDS_PER_PAGE = 32
+
+_TABLE_RE = re.compile(r"GSLX680_FW\[\]\s*=\s*\{(.*?)\};", re.DOTALL)
+_ENTRY_RE = re.compile(r"\{\s*(0x[0-9a-fA-F]+|\d+)\s*,\s*(0x[0-9a-fA-F]+|\d+)\s*\}")
+_BLOCK_COMMENT_RE = re.compile(r"/\*.*?\*/", re.DOTALL)
+_LINE_COMMENT_RE = re.compile(r"//[^\n]*")
+
+
+def parse_firmware(path=FW_HEADER):
+    """Return the (offset, value) pairs of GSLX680_FW in upload order."""
+    text = Path(path).read_text(encoding="utf-8")
+    text = _LINE_COMMENT_RE.sub("", _BLOCK_COMMENT_RE.sub("", text))
+    table = _TABLE_RE.search(text)
+    if table is None:
+        raise ValueError(f"GSLX680_FW table not found in {path}")
+    return [
+        (int(offset, 0) & 0xFF, int(value, 0) & 0xFFFFFFFF)
+        for offset, value in _ENTRY_RE.findall(table.group(1))
+    ]
+
+
+def segment_firmware(entries):
+    """Group the table into (page, start, [words]) runs of consecutive offsets.
+
+    A page select always ends the current run, even if it selects the same page.
+    """
+    segments = []
+    page = None
+    current = None
+    for offset, value in entries:
+        if offset == PAGE_REG:
+            page = value & 0xFF
+            current = None
+            continue
+        if page is None:
+            raise ValueError("GSLX680_FW writes a word before selecting a page")
+        if offset % 4 or offset >= WORDS_PER_PAGE * 4:
+            raise ValueError(f"GSLX680_FW offset 0x{offset:02x} is outside a page")
+        if current is None or current[1] + len(current[2]) * 4 != offset:
+            current = (page, offset, [])
+            segments.append(current)
+        current[2].append(value)
+    return segments
+
+
+def pack_firmware(entries):
+    """Encode the table into the blob consumed by esp_lcd_touch_gsl3680_load_fw_packed()."""
+    blob = bytearray()
+    for page, start, words in segment_firmware(entries):
+        blob += bytes((page, start, len(words)))
+        for word in words:
+            blob += word.to_bytes(4, "little")
+    return bytes(blob)
+
+
+def firmware_signature(entries):
+    """Return (page, start, words, digest) identifying the firmware in controller RAM.
+
+    The last segment carries the vendor string and build date of the firmware, so
+    its FNV-1a digest tells a resident copy from a different or missing one.
+    """
+    page, start, words = segment_firmware(entries)[-1]
+    digest = 0x811C9DC5
+    for word in words:
+        for byte in word.to_bytes(4, "little"):
+            digest = ((digest ^ byte) * 0x01000193) & 0xFFFFFFFF
+    return page, start, len(words), digest or 1
@@ -5,9 +5,10 @@ namespace gsl3680 {
 
 void GSL3680::setup() {
 
-    esp_lcd_panel_io_i2c_config_t tp_io_config = ESP_LCD_TOUCH_IO_I2C_GSL3680_CONFIG();
-    ESP_LOGI(TAG, "Initialize touch IO (I2C)");
-    esp_lcd_new_panel_io_i2c((esp_lcd_i2c_bus_handle_t)I2C_NUM_0, &tp_io_config, &this->tp_io_handle_);
+    ESP_LOGI(TAG, "Initialize touch IO (I2C address 0x%02x)", this->address_);
+    this->panel_io_.base.rx_param = GSL3680::io_rx_param_;
+    this->panel_io_.base.tx_param = GSL3680::io_tx_param_;
+    this->panel_io_.parent = this;
     this->x_raw_max_ = this->swap_x_y_? this->get_display()->get_native_height(): this->get_display()->get_native_width() ;
     this->y_raw_max_ = this->swap_x_y_? this->get_display()->get_native_width() : this->get_display()->get_native_height();
 
@@ -25,16 +26,195 @@ void GSL3680::setup() {
             .mirror_y = 0,
         },
     };
+    this->gsl_config_.dev_addr = this->address_;
+    tp_cfg.driver_data = &this->gsl_config_;
 
     ESP_LOGI(TAG, "Initialize touch controller gsl3680");
-    ESP_ERROR_CHECK(esp_lcd_touch_new_i2c_gsl3680(this->tp_io_handle_, &tp_cfg, &this->tp_));
+    ESP_ERROR_CHECK(esp_lcd_touch_new_i2c_gsl3680_async(&this->panel_io_.base, &tp_cfg, &this->tp_));
 
-    this->interrupt_pin_->setup();
-    this->attach_interrupt_(this->interrupt_pin_, gpio::INTERRUPT_ANY_EDGE);
+    // Reset and firmware upload are stepped from loop(), keep it spinning until the controller runs
+    this->bringup_loop_.start();
+}
+
+void GSL3680::loop() {
+    if (!this->ready_) {
+        esp_err_t err = esp_lcd_touch_gsl3680_bringup_poll(this->tp_);
+        if (err == ESP_ERR_NOT_FINISHED) {
+            return;
+        }
+        this->bringup_loop_.stop();
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Touch controller bring-up failed: %s", esp_err_to_name(err));
+            this->mark_failed();
+            return;
+        }
+        this->ready_ = true;
+        this->report_boot_info_();
+
+        this->interrupt_pin_->setup();
+        if (this->use_task_ && !this->start_acquisition_task_()) {
+            ESP_LOGW(TAG, "Falling back to reading the controller from the main loop");
+            this->use_task_ = false;
+        }
+        if (!this->use_task_) {
+            this->attach_interrupt_(this->interrupt_pin_, gpio::INTERRUPT_ANY_EDGE);
+        }
+
+        if (this->bus_bytes_saved_sensor_ != nullptr) {
+            this->last_stats_ms_ = millis();
+            this->set_interval("read_stats", 10000, [this]() { this->publish_read_stats_(); });
+        }
+        if (this->gsl_config_.adaptive_delay) {
+            this->set_interval("delay_stats", 10000, [this]() { this->log_delay_stats_(); });
+        }
+    }
+    Touchscreen::loop();
+
+    // Touchscreen::loop() clears the flag after update_touches(), which may hide frames queued meanwhile
+    if (this->use_task_ && this->frame_tail_.load(std::memory_order_relaxed) != this->frame_head_.load(std::memory_order_acquire)) {
+        this->store_.touched = true;
+    }
+}
+
+esp_err_t GSL3680::io_rx_param_(esp_lcd_panel_io_t *io, int lcd_cmd, void *param, size_t param_size) {
+    GSL3680 *self = reinterpret_cast<PanelIO *>(io)->parent;
+    i2c::ErrorCode err = self->read_register(lcd_cmd, static_cast<uint8_t *>(param), param_size);
+    return err == i2c::ERROR_OK ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t GSL3680::io_tx_param_(esp_lcd_panel_io_t *io, int lcd_cmd, const void *param, size_t param_size) {
+    GSL3680 *self = reinterpret_cast<PanelIO *>(io)->parent;
+    i2c::ErrorCode err = self->write_register(lcd_cmd, static_cast<const uint8_t *>(param), param_size);
+    return err == i2c::ERROR_OK ? ESP_OK : ESP_FAIL;
+}
+
+bool GSL3680::start_acquisition_task_() {
+    if (xTaskCreatePinnedToCore(GSL3680::acquisition_task_, "gsl3680", 4096, this, this->task_priority_,
+                                &this->task_handle_, this->task_core_) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create the acquisition task on core %u", this->task_core_);
+        this->task_handle_ = nullptr;
+        return false;
+    }
+    // The task now owns the controller; store_.init stops Touchscreen::update() from polling it
+    this->store_.init = true;
+    this->interrupt_pin_->attach_interrupt(GSL3680::gpio_isr_, this, gpio::INTERRUPT_ANY_EDGE);
+    ESP_LOGI(TAG, "Acquisition task started on core %u, priority %u", this->task_core_, this->task_priority_);
+    return true;
+}
+
+void IRAM_ATTR GSL3680::gpio_isr_(GSL3680 *arg) {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(arg->task_handle_, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+void GSL3680::acquisition_task_(void *arg) {
+    GSL3680 *self = static_cast<GSL3680 *>(arg);
+    bool active = true;
+
+    while (true) {
+        // While a finger is down, or its release has not been queued yet, keep reading at
+        // the controller frame rate even if an edge is missed
+        ulTaskNotifyTake(pdTRUE, active ? pdMS_TO_TICKS(20) : portMAX_DELAY);
+
+        uint8_t head = self->frame_head_.load(std::memory_order_relaxed);
+        TouchFrame *frame = &self->frames_[head & (FRAME_RING_SIZE - 1)];
+        if (uint8_t(head - self->frame_tail_.load(std::memory_order_acquire)) == FRAME_RING_SIZE) {
+            TouchFrame dropped;
+            self->read_frame_(&dropped);
+            self->frames_dropped_.fetch_add(1, std::memory_order_relaxed);
+            active = true;
+            continue;
+        }
+        self->read_frame_(frame);
+        self->frame_head_.store(head + 1, std::memory_order_release);
+        self->store_.touched = true;
+        active = frame->count != 0;
+    }
+}
+
+void GSL3680::read_frame_(TouchFrame *frame) {
+    esp_lcd_touch_read_data(this->tp_);
+    frame->timestamp_us = esp_timer_get_time();
+    if (!esp_lcd_touch_get_coordinates(this->tp_, frame->x, frame->y, frame->id, &frame->count,
+                                       CONFIG_ESP_LCD_TOUCH_MAX_POINTS)) {
+        frame->count = 0;
+    }
+}
+
+void GSL3680::publish_read_stats_() {
+    esp_lcd_touch_gsl3680_read_stats_t stats;
+    if (esp_lcd_touch_gsl3680_get_read_stats(this->tp_, &stats) != ESP_OK) {
+        return;
+    }
+
+    uint32_t now = millis();
+    uint32_t elapsed_ms = now - this->last_stats_ms_;
+    if (elapsed_ms == 0) {
+        return;
+    }
+    // Unsigned deltas stay correct across counter wrap-around
+    uint32_t saved = stats.bytes_saved - this->last_bytes_saved_;
+    this->last_bytes_saved_ = stats.bytes_saved;
+    this->last_stats_ms_ = now;
+
+    ESP_LOGV(TAG, "Reads: %u frames, %u idle, %u bytes read, %u bytes saved", (unsigned) stats.frames,
+             (unsigned) stats.idle_frames, (unsigned) stats.bytes_read, (unsigned) stats.bytes_saved);
+    this->bus_bytes_saved_sensor_->publish_state(saved * 1000.0f / elapsed_ms);
+}
 
+void GSL3680::log_delay_stats_() {
+    esp_lcd_touch_gsl3680_delay_stats_t stats;
+    if (esp_lcd_touch_gsl3680_get_delay_stats(this->tp_, &stats) != ESP_OK) {
+        return;
+    }
+    ESP_LOGD(TAG, "Report delay: %u frames held, %u early, %u after the delay, %u dropped, %u unsteady, noise %u/16",
+             (unsigned) stats.held, (unsigned) stats.early, (unsigned) stats.released, (unsigned) stats.dropped,
+             (unsigned) stats.unsteady, (unsigned) stats.noise);
+}
+
+void GSL3680::report_boot_info_() {
+    esp_lcd_touch_gsl3680_boot_info_t info;
+    if (esp_lcd_touch_gsl3680_get_boot_info(this->tp_, &info) != ESP_OK) {
+        return;
+    }
+
+    // The last cold upload time is kept in flash, so a warm start can report what it saved.
+    // Every panel has its own reset line, which keeps the key apart when there are several.
+    this->fw_load_pref_ = global_preferences->make_preference<uint32_t>(fnv1_hash("gsl3680_fw_load_us") ^
+                                                                        this->reset_pin_->get_pin());
+    uint32_t load_us = 0;
+    if (!info.fw_reused) {
+        load_us = info.fw_load_us;
+        this->fw_load_pref_.save(&load_us);
+    } else if (!this->fw_load_pref_.load(&load_us)) {
+        load_us = 0;
+    }
+
+    uint32_t saved_us = info.fw_reused && load_us > info.fw_verify_us ? load_us - info.fw_verify_us : 0;
+    ESP_LOGI(TAG, "Firmware %s: check %u us, upload %u us, saved %u us", info.fw_reused ? "reused" : "uploaded",
+             (unsigned) info.fw_verify_us, (unsigned) info.fw_load_us, (unsigned) saved_us);
+    if (this->firmware_time_saved_sensor_ != nullptr) {
+        this->firmware_time_saved_sensor_->publish_state(saved_us / 1000.0f);
+    }
 }
 
 void GSL3680::update_touches() {
+    if (this->use_task_) {
+        uint8_t tail = this->frame_tail_.load(std::memory_order_relaxed);
+        if (tail == this->frame_head_.load(std::memory_order_acquire)) {
+            return;
+        }
+        const TouchFrame &frame = this->frames_[tail & (FRAME_RING_SIZE - 1)];
+        ESP_LOGV(TAG, "Frame with %u touches, %lld us old, %u dropped", frame.count,
+                 (long long) (esp_timer_get_time() - frame.timestamp_us), (unsigned) this->frames_dropped_.load());
+        for (int i = 0; i < frame.count; i++) {
+            this->add_raw_touch_position_(frame.id[i], frame.x[i], frame.y[i]);
+        }
+        this->frame_tail_.store(tail + 1, std::memory_order_release);
+        return;
+    }
+
     uint16_t x[CONFIG_ESP_LCD_TOUCH_MAX_POINTS];
     uint16_t y[CONFIG_ESP_LCD_TOUCH_MAX_POINTS];
     uint16_t touch_strength[CONFIG_ESP_LCD_TOUCH_MAX_POINTS];
@@ -44,9 +224,9 @@ void GSL3680::update_touches() {
     if (touchpad_pressed) {
         for (int i = 0; i < touch_cnt; i++) {
             ESP_LOGV(TAG, "GSL3680::update_touches: [%d] %dx%d - %d, %d", i, x[i], y[i], touch_strength[i], touch_cnt);
-            this->add_raw_touch_position_(i, x[i], y[i]);
+            // The driver reports the tracking id assigned by the point id algorithm as strength
+            this->add_raw_touch_position_(touch_strength[i], x[i], y[i]);
         }
-        this->add_raw_touch_position_(0, x[0], y[0]); // Second touch coords are weird
     }
 }
 
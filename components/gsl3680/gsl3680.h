@@ -6,28 +6,105 @@
 #include "esphome/components/i2c/i2c.h"
 #include "esphome/components/touchscreen/touchscreen.h"
 #include "esphome/core/hal.h"
+#include "esphome/core/preferences.h"
+#include "esphome/components/sensor/sensor.h"
 #include "esp_lcd_gsl3680.h"
+#include "esp_lcd_panel_io_interface.h"
+
+#include <atomic>
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 namespace esphome {
 namespace gsl3680 {
 
 constexpr static const char *const TAG = "touchscreen.gsl3680";
 
+// Frames buffered between the acquisition task and update_touches(), must be a power of two
+static const uint8_t FRAME_RING_SIZE = 8;
+
+struct TouchFrame {
+    int64_t timestamp_us;
+    uint8_t count;
+    uint16_t x[CONFIG_ESP_LCD_TOUCH_MAX_POINTS];
+    uint16_t y[CONFIG_ESP_LCD_TOUCH_MAX_POINTS];
+    uint16_t id[CONFIG_ESP_LCD_TOUCH_MAX_POINTS];
+};
+
 class GSL3680 : public touchscreen::Touchscreen, public i2c::I2CDevice {
     public:
         void setup() override;
+        void loop() override;
         void update_touches() override;
 
         void set_interrupt_pin(InternalGPIOPin *pin) { this->interrupt_pin_ = pin; }
         void set_reset_pin(InternalGPIOPin *pin) { this->reset_pin_ = pin; }
+        void set_firmware_burst_size(uint8_t words) { this->gsl_config_.fw_burst_words = words; }
+        void set_firmware_data(const uint8_t *data, size_t len) {
+            this->gsl_config_.fw_blob = data;
+            this->gsl_config_.fw_blob_len = len;
+        }
+        void set_firmware_signature(uint8_t page, uint8_t start, uint8_t words, uint32_t digest) {
+            this->gsl_config_.fw_sig_page = page;
+            this->gsl_config_.fw_sig_start = start;
+            this->gsl_config_.fw_sig_words = words;
+            this->gsl_config_.fw_sig_digest = digest;
+        }
+        void set_max_touch_points(uint8_t points) { this->gsl_config_.max_points = points; }
+        void set_lookahead(uint16_t ms) { this->gsl_config_.lookahead_ms = ms; }
+        void set_adaptive_delay(bool adaptive) { this->gsl_config_.adaptive_delay = adaptive; }
+        void set_firmware_time_saved_sensor(sensor::Sensor *sensor) { this->firmware_time_saved_sensor_ = sensor; }
+        void set_bus_bytes_saved_sensor(sensor::Sensor *sensor) { this->bus_bytes_saved_sensor_ = sensor; }
+        // The task reads the controller through this I2CDevice outside the main loop. I2CBus has no lock, so
+        // touchscreen.py only accepts the task when no other device shares the bus.
+        void set_acquisition_task(uint8_t core, uint8_t priority) {
+            this->task_core_ = core;
+            this->task_priority_ = priority;
+            this->use_task_ = true;
+        }
 
     protected:
+        // esp_lcd panel IO backed by this I2CDevice, so the driver talks on the configured bus and address
+        struct PanelIO {
+            esp_lcd_panel_io_t base;
+            GSL3680 *parent;
+        };
+        static esp_err_t io_rx_param_(esp_lcd_panel_io_t *io, int lcd_cmd, void *param, size_t param_size);
+        static esp_err_t io_tx_param_(esp_lcd_panel_io_t *io, int lcd_cmd, const void *param, size_t param_size);
+
+        void report_boot_info_();
+        void publish_read_stats_();
+        void log_delay_stats_();
+        void read_frame_(TouchFrame *frame);
+        bool start_acquisition_task_();
+        static void acquisition_task_(void *arg);
+        static void gpio_isr_(GSL3680 *arg);
+
         InternalGPIOPin *interrupt_pin_{};
         InternalGPIOPin *reset_pin_{};
         size_t width_ = 1280;
         size_t height_ = 800;
         esp_lcd_touch_handle_t tp_{};
-        esp_lcd_panel_io_handle_t tp_io_handle_{};
+        PanelIO panel_io_{};
+        esp_lcd_touch_io_gsl3680_config_t gsl_config_{};
+        HighFrequencyLoopRequester bringup_loop_;
+        bool ready_{false};
+        sensor::Sensor *firmware_time_saved_sensor_{};
+        sensor::Sensor *bus_bytes_saved_sensor_{};
+        uint32_t last_bytes_saved_{0};
+        uint32_t last_stats_ms_{0};
+        ESPPreferenceObject fw_load_pref_;
+
+        // Acquisition task mode: the task is the only writer of frame_head_, update_touches() the only writer of frame_tail_
+        bool use_task_{false};
+        uint8_t task_core_{1};
+        uint8_t task_priority_{5};
+        TaskHandle_t task_handle_{};
+        TouchFrame frames_[FRAME_RING_SIZE];
+        std::atomic<uint8_t> frame_head_{0};
+        std::atomic<uint8_t> frame_tail_{0};
+        std::atomic<uint32_t> frames_dropped_{0};
 };
 
 }
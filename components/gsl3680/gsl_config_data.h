@@ -0,0 +1,7 @@
+#ifndef _GSL_CONFIG_DATA_H
+#define _GSL_CONFIG_DATA_H
+
+/* Point id algorithm settings matching the firmware in esp_lcd_gsl3680.h */
+extern unsigned int gsl_config_data_id[];
+
+#endif
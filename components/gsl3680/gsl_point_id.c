@@ -16,8 +16,15 @@
  */
 // #include "bsp/lcd_gsl3680.h"
 #include "gsl_point_id.h"
-#include "esp_log.h"
 #include "stdio.h"
+#include <string.h>
+#ifdef ESP_PLATFORM
+#include "esp_log.h"
+#else
+/* Host builds (trace replay, profiling) only need the one log call, kept
+ * off stdout so it does not mix with the replayed points */
+#define ESP_LOGI(tag, format, ...) fprintf(stderr, "I %s: " format "\n", tag, ##__VA_ARGS__)
+#endif
 
 #define GSL_VERSION                                                            \
 	0x20160901 /* NO GESTURE VERSION COME FROM VERSION 20150706 */
@@ -37,9 +44,25 @@
 #define POINT_DEEP (PP_DEEP + PS_DEEP + PR_DEEP)
 #define PRESSURE_DEEP 8
 #define INTE_INIT 8
+/* empty frames in and out before the history rings are all zero again and
+ * the delay and pressure state has settled */
+#define IDLE_FRAMES POINT_DEEP
+/* coordinates CoordinateCorrect() finds in its tables, ex mode x above
+ * that takes the branches */
+#define CC_TABLE_SIZE 4096
+/* longest lookahead in 1/256 frames, a straight step overshoots every turn
+ * further out than that */
+#define LOOKAHEAD_MAX (4 << 8)
+/* adaptive report delay: a new finger seen DELAY_SEEN_MIN frames is released
+ * early once its speed is under twice the still noise of reported fingers,
+ * kept within DELAY_STILL_MIN and DELAY_STILL_MAX */
+#define DELAY_SEEN_MIN 2
+#define DELAY_STILL_MIN 3
+#define DELAY_STILL_MAX 12
 #define CONFIG_LENGTH 512
 #define TRUE 1
 #define FALSE 0
+#define FLAG_PREDICT (0x8 << 12)
 #define FLAG_ABLE (0x4 << 12)
 #define FLAG_FILL (0x2 << 12)
 #define FLAG_KEY (0x1 << 12)
@@ -60,7 +83,18 @@ struct gsl_DISTANCE_TYPE {
 	unsigned int i;
 	unsigned int j;
 	unsigned int min;		      /* distance min */
-	unsigned int d[POINT_MAX][POINT_MAX]; /* distance; */
+	unsigned int rows;		      /* bit j: point_now[j] not matched yet */
+	unsigned int cols;		      /* bit i: pp[0][i] not matched yet */
+	unsigned int row_min[POINT_MAX];      /* smallest d[j][] over cols */
+	unsigned char row_arg[POINT_MAX];     /* first column holding row_min */
+	unsigned int d[POINT_MAX][POINT_MAX]; /* distance, valid in rows x cols */
+};
+
+/* n / d for a divisor fixed by the config, see RecipInit() */
+struct gsl_RECIP_TYPE {
+	int d;
+	unsigned int m; /* 0: divide */
+	unsigned int s;
 };
 
 union gsl_POINT_TYPE {
@@ -80,6 +114,15 @@ union gsl_POINT_TYPE {
 	unsigned int all;
 };
 
+/* FilterOne() taps of one coefficient set, zero ones left out. row points
+ * at the ps[] or pr[] entry, which follows the rings from frame to frame */
+struct gsl_FIR_TYPE {
+	int num;
+	union gsl_POINT_TYPE **row[16];
+	int coe[16];
+	struct gsl_RECIP_TYPE den;
+};
+
 union gsl_DELAY_TYPE {
 	struct {
 		unsigned delay : 8;
@@ -186,31 +229,295 @@ union gsl_ID_FLAG_TYPE {
 	} other;
 	unsigned int all;
 };
-static union {
-	struct {
-		unsigned char id;
-		unsigned char num;
-		unsigned char rev_1;
-		unsigned char rev_2;
-	} other;
-	unsigned int all;
-} prec_id;
-
-static union gsl_POINT_TYPE point_array[POINT_DEEP][POINT_MAX];
-static union gsl_POINT_TYPE *point_pointer[PP_DEEP];
-static union gsl_POINT_TYPE *point_stretch[PS_DEEP];
-static union gsl_POINT_TYPE *point_report[PR_DEEP];
-static union gsl_POINT_TYPE point_now[POINT_MAX];
-static union gsl_DELAY_TYPE point_delay[POINT_MAX];
-static int filter_deep[POINT_MAX];
-static int avg[AVG_DEEP];
-static struct gsl_EDGE_TYPE point_edge;
-static union gsl_DECIMAL_TYPE point_decimal[POINT_MAX];
-
-static unsigned int pressure_now[POINT_MAX];
-static unsigned int pressure_array[PRESSURE_DEEP][POINT_MAX];
-static unsigned int pressure_report[POINT_MAX];
-static unsigned int *pressure_pointer[PRESSURE_DEEP];
+#ifdef GSL_STAGE_PROFILE
+/* Stages of gsl_alg_id_main_ctx() in call order, GetPointNum runs three times */
+#define GSL_STAGES(X)                                                          \
+	X(GetFlag) X(DataCheck) X(PressureSave) X(PointIgnore) X(PointCoor)    \
+	X(CoordinateCorrect) X(PointEdge) X(PointRound) X(PointRepeat)         \
+	X(GetPointNum_now) X(PointPointer) X(PointPredict) X(PointId)          \
+	X(PointNewId) X(PointOrder) X(GetPointNum_pp) X(PointCross)            \
+	X(ResetMask) X(PointStretch) X(PointDiagonal) X(PointFilter)           \
+	X(GetPointNum_pr) X(PointDelay) X(PointMenu) X(PointExtend)            \
+	X(PointPressure) X(PressMove) X(PressMask) X(PointReport)
+
+#define GSL_STAGE_ENUM(name) GSL_STAGE_##name,
+#define GSL_STAGE_NAME(name) #name,
+enum { GSL_STAGES(GSL_STAGE_ENUM) GSL_STAGE_ALL, GSL_STAGE_COUNT };
+static const char *const gsl_stage_names[GSL_STAGE_COUNT] = {
+	GSL_STAGES(GSL_STAGE_NAME) "total"
+};
+
+#ifndef GSL_STAGE_PROFILE_SAMPLES
+#define GSL_STAGE_PROFILE_SAMPLES 128
+#endif
+
+#ifdef ESP_PLATFORM
+#include "esp_cpu.h"
+#define gsl_stage_clock() ((unsigned int)esp_cpu_get_cycle_count())
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define gsl_stage_clock() ((unsigned int)__rdtsc())
+#else
+#include <time.h>
+static unsigned int gsl_stage_clock(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned int)(ts.tv_sec * 1000000000u + ts.tv_nsec);
+}
+#endif
+#endif
+
+/* All algorithm state, one per controller. point_pointer, point_stretch,
+ * point_report and pressure_pointer point into the same context, so a
+ * context must not be copied once gsl_DataInit_ctx(ctx) has run.
+ *
+ * Each history is a ring of rows listed twice over in point_ring and
+ * pressure_ring by gsl_id_reg_init(), entry k being the row k frames
+ * older than entry 0. A new frame steps point_base back by one and pp[],
+ * ps[], pr[] and pa[] are the window starting there, no wrap to work out.
+ * Rows keep the packed gsl_POINT_TYPE of every slot side by side, the way
+ * every stage reads, compares and copies them as whole words. A finger-major
+ * ring with the same O(1) step scans faster (tools/layout_bench.c), but
+ * would mean rewriting each stage against it. */
+struct gsl_alg_ctx {
+	union {
+		struct {
+			unsigned char id;
+			unsigned char num;
+			unsigned char rev_1;
+			unsigned char rev_2;
+		} other;
+		unsigned int all;
+	} prec_id;
+
+	union gsl_POINT_TYPE point_array[POINT_DEEP][POINT_MAX];
+	union gsl_POINT_TYPE *point_ring[3][PP_DEEP * 2];
+	union gsl_POINT_TYPE *point_pointer[PP_DEEP];
+	union gsl_POINT_TYPE *point_stretch[PS_DEEP];
+	union gsl_POINT_TYPE *point_report[PR_DEEP];
+	union gsl_POINT_TYPE point_now[POINT_MAX];
+	union gsl_DELAY_TYPE point_delay[POINT_MAX];
+	int filter_deep[POINT_MAX];
+	int avg[AVG_DEEP];
+	struct gsl_EDGE_TYPE point_edge;
+	union gsl_DECIMAL_TYPE point_decimal[POINT_MAX];
+
+	unsigned int pressure_now[POINT_MAX];
+	unsigned int pressure_array[PRESSURE_DEEP][POINT_MAX];
+	unsigned int pressure_report[POINT_MAX];
+	unsigned int *pressure_ring[PRESSURE_DEEP * 2];
+	unsigned int *pressure_pointer[PRESSURE_DEEP];
+
+	union gsl_STATE_TYPE global_state;
+	int inte_count;
+	int idle_count;
+	unsigned int csensor_count;
+	int point_base;
+	int pressure_base;
+	int point_num;
+	/* slots of the row GetPointNum() counted last. Counted from pp[0]
+	 * before PointCross(), which only swaps set slots, and walked by it,
+	 * PointStretch() and PointFilter() */
+	unsigned int point_mask;
+	int prev_num;
+	int point_near;
+	unsigned int point_shake;
+	unsigned int reset_mask_send;
+	unsigned int reset_mask_max;
+	unsigned int reset_mask_count;
+	union gsl_FLAG_TYPE global_flag;
+	union gsl_ID_FLAG_TYPE id_flag;
+	unsigned int id_first_coe;
+	unsigned int id_speed_coe;
+	unsigned int id_static_coe;
+	unsigned int average;
+	unsigned int soft_average;
+	unsigned int report_delay;
+	unsigned int delay_key;
+	unsigned int report_ahead;
+	unsigned int report_delete;
+	unsigned char median_dis[4];
+	unsigned int shake_min;
+	int match_y[2];
+	int match_x[2];
+	int ignore_y[2];
+	int ignore_x[2];
+	int screen_y_max;
+	int screen_x_max;
+	int point_num_max;
+	unsigned int drv_num;
+	unsigned int sen_num;
+	unsigned int drv_num_nokey;
+	unsigned int sen_num_nokey;
+	unsigned int coordinate_correct_able;
+	unsigned int coordinate_correct_coe_x[64];
+	unsigned int coordinate_correct_coe_y[64];
+	unsigned int edge_cut[4];
+	unsigned int stretch_array[4 * 4 * 2];
+	unsigned int stretch_active[4 * 4 * 2];
+	unsigned int shake_all_array[2 * 8];
+	unsigned int edge_start;
+	unsigned int reset_mask_dis;
+	unsigned int reset_mask_type;
+	unsigned int key_map_able;
+	unsigned int key_range_array[8 * 3];
+	int filter_able;
+	unsigned int filter_coe[4];
+	unsigned int multi_x_array[4], multi_y_array[4];
+	unsigned int multi_group[4][64];
+	int ps_coe[4][8], pr_coe[4][8];
+	int point_repeat[2];
+	/* static	int near_set[2]; */
+	int diagonal;
+	int point_extend;
+	unsigned int press_mask;
+	union gsl_POINT_TYPE point_press_move;
+	unsigned int press_move;
+	/* unsigned int key_dead_time			; */
+	/* unsigned int point_dead_time		; */
+	/* unsigned int point_dead_time2		; */
+	/* unsigned int point_dead_distance	; */
+	/* unsigned int point_dead_distance2	; */
+	/* unsigned int pressure_able; */
+	/* unsigned int pressure_save[POINT_MAX]; */
+	unsigned int edge_first;
+	unsigned int edge_first_coe;
+	unsigned int point_corner;
+	unsigned int stretch_mult;
+	/* ------------------------------------------------- */
+	unsigned int config_static[CONFIG_LENGTH];
+	int save_dr[POINT_MAX], save_dn[POINT_MAX];
+	/* reso_x/reso_y scaling of PointDistance(), fixed by gsl_DataInit */
+	int dis_scale_mul, dis_grid_mul;
+	struct gsl_RECIP_TYPE dis_scale_div, dis_grid_div;
+	/* config divisors of ScreenResolution(), PointIgnore() and
+	 * DiagonalDistance() */
+	struct gsl_RECIP_TYPE recip_res_x, recip_res_y, recip_diagonal;
+	/* CoordinateCorrectAxis() of every coordinate outside the active
+	 * state, built by CoordinateCorrectInit() */
+	unsigned short coordinate_correct_x[CC_TABLE_SIZE];
+	unsigned short coordinate_correct_y[CC_TABLE_SIZE];
+	/* filter_coe, or ps_coe/pr_coe by filter_deep, see FilterInit() */
+	struct gsl_FIR_TYPE filter_fir[4];
+	/* PointReport() horizon in 1/256 frames, 0 reports the filtered point */
+	int lookahead;
+	/* nonzero releases settled new fingers before report_delay runs out */
+	int adaptive_delay;
+	struct gsl_delay_stat delay_stat;
+	/* slots PointDelay() held back in the last frame */
+	unsigned int delay_held;
+#ifdef GSL_STAGE_PROFILE
+	/* last GSL_STAGE_PROFILE_SAMPLES durations of every stage, ring indexed by count */
+	unsigned int stage_ticks[GSL_STAGE_COUNT][GSL_STAGE_PROFILE_SAMPLES];
+	unsigned int stage_count[GSL_STAGE_COUNT];
+#endif
+};
+
+/* The vendor code below keeps using the old global names, each one is a
+ * field of the context passed to every function as ctx */
+#define point_array (ctx->point_array)
+#define point_ring (ctx->point_ring)
+#define point_pointer (ctx->point_pointer)
+#define point_stretch (ctx->point_stretch)
+#define point_report (ctx->point_report)
+#define point_now (ctx->point_now)
+#define point_delay (ctx->point_delay)
+#define filter_deep (ctx->filter_deep)
+#define avg (ctx->avg)
+#define point_edge (ctx->point_edge)
+#define point_decimal (ctx->point_decimal)
+#define pressure_now (ctx->pressure_now)
+#define pressure_array (ctx->pressure_array)
+#define pressure_report (ctx->pressure_report)
+#define pressure_ring (ctx->pressure_ring)
+#define pressure_pointer (ctx->pressure_pointer)
+#define global_state (ctx->global_state)
+#define inte_count (ctx->inte_count)
+#define idle_count (ctx->idle_count)
+#define csensor_count (ctx->csensor_count)
+#define point_base (ctx->point_base)
+#define pressure_base (ctx->pressure_base)
+#define point_num (ctx->point_num)
+#define point_mask (ctx->point_mask)
+#define prev_num (ctx->prev_num)
+#define point_near (ctx->point_near)
+#define point_shake (ctx->point_shake)
+#define reset_mask_send (ctx->reset_mask_send)
+#define reset_mask_max (ctx->reset_mask_max)
+#define reset_mask_count (ctx->reset_mask_count)
+#define global_flag (ctx->global_flag)
+#define id_flag (ctx->id_flag)
+#define id_first_coe (ctx->id_first_coe)
+#define id_speed_coe (ctx->id_speed_coe)
+#define id_static_coe (ctx->id_static_coe)
+#define average (ctx->average)
+#define soft_average (ctx->soft_average)
+#define report_delay (ctx->report_delay)
+#define delay_key (ctx->delay_key)
+#define report_ahead (ctx->report_ahead)
+#define report_delete (ctx->report_delete)
+#define median_dis (ctx->median_dis)
+#define shake_min (ctx->shake_min)
+#define match_y (ctx->match_y)
+#define match_x (ctx->match_x)
+#define ignore_y (ctx->ignore_y)
+#define ignore_x (ctx->ignore_x)
+#define screen_y_max (ctx->screen_y_max)
+#define screen_x_max (ctx->screen_x_max)
+#define point_num_max (ctx->point_num_max)
+#define drv_num (ctx->drv_num)
+#define sen_num (ctx->sen_num)
+#define drv_num_nokey (ctx->drv_num_nokey)
+#define sen_num_nokey (ctx->sen_num_nokey)
+#define coordinate_correct_able (ctx->coordinate_correct_able)
+#define coordinate_correct_coe_x (ctx->coordinate_correct_coe_x)
+#define coordinate_correct_coe_y (ctx->coordinate_correct_coe_y)
+#define edge_cut (ctx->edge_cut)
+#define stretch_array (ctx->stretch_array)
+#define stretch_active (ctx->stretch_active)
+#define shake_all_array (ctx->shake_all_array)
+#define edge_start (ctx->edge_start)
+#define reset_mask_dis (ctx->reset_mask_dis)
+#define reset_mask_type (ctx->reset_mask_type)
+#define key_map_able (ctx->key_map_able)
+#define key_range_array (ctx->key_range_array)
+#define filter_able (ctx->filter_able)
+#define filter_coe (ctx->filter_coe)
+#define multi_x_array (ctx->multi_x_array)
+#define multi_y_array (ctx->multi_y_array)
+#define multi_group (ctx->multi_group)
+#define ps_coe (ctx->ps_coe)
+#define pr_coe (ctx->pr_coe)
+#define point_repeat (ctx->point_repeat)
+#define diagonal (ctx->diagonal)
+#define point_extend (ctx->point_extend)
+#define press_mask (ctx->press_mask)
+#define point_press_move (ctx->point_press_move)
+#define press_move (ctx->press_move)
+#define edge_first (ctx->edge_first)
+#define edge_first_coe (ctx->edge_first_coe)
+#define point_corner (ctx->point_corner)
+#define stretch_mult (ctx->stretch_mult)
+#define config_static (ctx->config_static)
+#define prec_id (ctx->prec_id)
+#define save_dr (ctx->save_dr)
+#define save_dn (ctx->save_dn)
+#define dis_scale_mul (ctx->dis_scale_mul)
+#define dis_scale_div (ctx->dis_scale_div)
+#define dis_grid_mul (ctx->dis_grid_mul)
+#define dis_grid_div (ctx->dis_grid_div)
+#define recip_res_x (ctx->recip_res_x)
+#define recip_res_y (ctx->recip_res_y)
+#define recip_diagonal (ctx->recip_diagonal)
+#define coordinate_correct_x (ctx->coordinate_correct_x)
+#define coordinate_correct_y (ctx->coordinate_correct_y)
+#define filter_fir (ctx->filter_fir)
+#define lookahead (ctx->lookahead)
+#define adaptive_delay (ctx->adaptive_delay)
+#define delay_stat (ctx->delay_stat)
+#define delay_held (ctx->delay_held)
 
 #define pp point_pointer
 #define ps point_stretch
@@ -218,81 +525,10 @@ static unsigned int *pressure_pointer[PRESSURE_DEEP];
 #define point_predict pp[0]
 #define pa pressure_pointer
 
-static union gsl_STATE_TYPE global_state;
-static int inte_count;
-static unsigned int csensor_count;
-static int point_n;
-static int point_num;
-static int prev_num;
-static int point_near;
-static unsigned int point_shake;
-static unsigned int reset_mask_send;
-static unsigned int reset_mask_max;
-static unsigned int reset_mask_count;
-static union gsl_FLAG_TYPE global_flag;
-static union gsl_ID_FLAG_TYPE id_flag;
-static unsigned int id_first_coe;
-static unsigned int id_speed_coe;
-static unsigned int id_static_coe;
-static unsigned int average;
-static unsigned int soft_average;
-static unsigned int report_delay;
-static unsigned int delay_key;
-static unsigned int report_ahead;
-static unsigned int report_delete;
-static unsigned char median_dis[4];
-static unsigned int shake_min;
-static int match_y[2];
-static int match_x[2];
-static int ignore_y[2];
-static int ignore_x[2];
-static int screen_y_max;
-static int screen_x_max;
-static int point_num_max;
-static unsigned int drv_num;
-static unsigned int sen_num;
-static unsigned int drv_num_nokey;
-static unsigned int sen_num_nokey;
-static unsigned int coordinate_correct_able;
-static unsigned int coordinate_correct_coe_x[64];
-static unsigned int coordinate_correct_coe_y[64];
-static unsigned int edge_cut[4];
-static unsigned int stretch_array[4 * 4 * 2];
-static unsigned int stretch_active[4 * 4 * 2];
-static unsigned int shake_all_array[2 * 8];
-static unsigned int edge_start;
-static unsigned int reset_mask_dis;
-static unsigned int reset_mask_type;
-static unsigned int key_map_able;
-static unsigned int key_range_array[8 * 3];
-static int filter_able;
-static unsigned int filter_coe[4];
-static unsigned int multi_x_array[4], multi_y_array[4];
-static unsigned int multi_group[4][64];
-static int ps_coe[4][8], pr_coe[4][8];
-static int point_repeat[2];
-/* static	int near_set[2]; */
-static int diagonal;
-static int point_extend;
-static unsigned int press_mask;
-static union gsl_POINT_TYPE point_press_move;
-static unsigned int press_move;
-/* unsigned int key_dead_time			; */
-/* unsigned int point_dead_time		; */
-/* unsigned int point_dead_time2		; */
-/* unsigned int point_dead_distance	; */
-/* unsigned int point_dead_distance2	; */
-/* unsigned int pressure_able; */
-/* unsigned int pressure_save[POINT_MAX]; */
-static unsigned int edge_first;
-static unsigned int edge_first_coe;
-static unsigned int point_corner;
-static unsigned int stretch_mult;
-/* ------------------------------------------------- */
-static unsigned int config_static[CONFIG_LENGTH];
 /* +++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
 
 /* +++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#ifdef GSL_STAGE_PROFILE
 static void SortBubble(int t[], int size)
 {
 	int temp = 0;
@@ -308,9 +544,45 @@ static void SortBubble(int t[], int size)
 		}
 	}
 }
+#endif
+
+#ifndef GSL_SQRT_BITWISE
+/* floor(sqrt(i << 8)): sqrt(i) with four fraction bits */
+static const unsigned char sqrt_tab[256] = {
+	0, 16, 22, 27, 32, 35, 39, 42, 45, 48, 50, 53,
+	55, 57, 59, 61, 64, 65, 67, 69, 71, 73, 75, 76,
+	78, 80, 81, 83, 84, 86, 87, 89, 90, 91, 93, 94,
+	96, 97, 98, 99, 101, 102, 103, 104, 106, 107, 108, 109,
+	110, 112, 113, 114, 115, 116, 117, 118, 119, 120, 121, 122,
+	123, 124, 125, 126, 128, 128, 129, 130, 131, 132, 133, 134,
+	135, 136, 137, 138, 139, 140, 141, 142, 143, 144, 144, 145,
+	146, 147, 148, 149, 150, 150, 151, 152, 153, 154, 155, 155,
+	156, 157, 158, 159, 160, 160, 161, 162, 163, 163, 164, 165,
+	166, 167, 167, 168, 169, 170, 170, 171, 172, 173, 173, 174,
+	175, 176, 176, 177, 178, 178, 179, 180, 181, 181, 182, 183,
+	183, 184, 185, 185, 186, 187, 187, 188, 189, 189, 190, 191,
+	192, 192, 193, 193, 194, 195, 195, 196, 197, 197, 198, 199,
+	199, 200, 201, 201, 202, 203, 203, 204, 204, 205, 206, 206,
+	207, 208, 208, 209, 209, 210, 211, 211, 212, 212, 213, 214,
+	214, 215, 215, 216, 217, 217, 218, 218, 219, 219, 220, 221,
+	221, 222, 222, 223, 224, 224, 225, 225, 226, 226, 227, 227,
+	228, 229, 229, 230, 230, 231, 231, 232, 232, 233, 234, 234,
+	235, 235, 236, 236, 237, 237, 238, 238, 239, 240, 240, 241,
+	241, 242, 242, 243, 243, 244, 244, 245, 245, 246, 246, 247,
+	247, 248, 248, 249, 249, 250, 250, 251, 251, 252, 252, 253,
+	253, 254, 254, 255,
+};
+#endif
 
+/*
+ * floor(sqrt(d)) clamped to 0..32767, what the 15-step bit search under
+ * GSL_SQRT_BITWISE returns. The table answers d < 256 and seeds the rest
+ * from the top 7-8 bits of d: below 2^16 the seed is at most two short,
+ * above it one Newton step lands at most a few over.
+ */
 static int Sqrt(int d)
 {
+#ifdef GSL_SQRT_BITWISE
 	int ret = 0;
 	int i;
 
@@ -319,9 +591,29 @@ static int Sqrt(int d)
 			ret |= (0x1 << i);
 	}
 	return ret;
+#else
+	int s, y;
+
+	if (d < 256)
+		return d > 0 ? sqrt_tab[d] >> 4 : 0;
+	if (d >= 32767 * 32767)
+		return 32767;
+	s = (25 - __builtin_clz(d)) & ~1;
+	if (s <= 8) {
+		y = sqrt_tab[d >> s] >> (4 - s / 2);
+		while ((y + 1) * (y + 1) <= d)
+			y++;
+	} else {
+		y = sqrt_tab[d >> s] << (s / 2 - 4);
+		y = (y + d / y) >> 1;
+		while (y * y > d)
+			y--;
+	}
+	return y;
+#endif
 }
 
-static UINT PointRange(int x0, int y0, int x1, int y1)
+static UINT PointRange(struct gsl_alg_ctx *ctx, int x0, int y0, int x1, int y1)
 {
 	if (x0 < 1) /* && x1>=1 */ {
 		if (x0 != x1)
@@ -358,7 +650,7 @@ static UINT PointRange(int x0, int y0, int x1, int y1)
 	return (x0 << 16) + y0;
 }
 
-static void PointCoor(void)
+static void PointCoor(struct gsl_alg_ctx *ctx)
 {
 	int i;
 
@@ -371,7 +663,7 @@ static void PointCoor(void)
 	}
 }
 
-static void PointRepeat(void)
+static void PointRepeat(struct gsl_alg_ctx *ctx)
 {
 	int i, j;
 	int x, y;
@@ -443,45 +735,17 @@ static void PointRepeat(void)
 	}
 }
 
-static void PointPointer(void)
+static void PointPointer(struct gsl_alg_ctx *ctx)
 {
-	int i, pn;
+	int i;
 
-	point_n++;
-	if (point_n >= PP_DEEP * PS_DEEP * PR_DEEP * PRESSURE_DEEP)
-		point_n = 0;
-	pn = point_n % PP_DEEP;
-	for (i = 0; i < PP_DEEP; i++) {
-		pp[i] = point_array[pn];
-		if (pn == 0)
-			pn = PP_DEEP - 1;
-		else
-			pn--;
-	}
-	pn = point_n % PS_DEEP;
-	for (i = 0; i < PS_DEEP; i++) {
-		ps[i] = point_array[pn + PP_DEEP];
-		if (pn == 0)
-			pn = PS_DEEP - 1;
-		else
-			pn--;
-	}
-	pn = point_n % PR_DEEP;
-	for (i = 0; i < PR_DEEP; i++) {
-		pr[i] = point_array[pn + PP_DEEP + PS_DEEP];
-		if (pn == 0)
-			pn = PR_DEEP - 1;
-		else
-			pn--;
-	}
-	pn = point_n % PRESSURE_DEEP;
-	for (i = 0; i < PRESSURE_DEEP; i++) {
-		pa[i] = pressure_array[pn];
-		if (pn == 0)
-			pn = PRESSURE_DEEP - 1;
-		else
-			pn--;
-	}
+	point_base = point_base == 0 ? PP_DEEP - 1 : point_base - 1;
+	pressure_base =
+		pressure_base == 0 ? PRESSURE_DEEP - 1 : pressure_base - 1;
+	memcpy(pp, point_ring[0] + point_base, sizeof(pp));
+	memcpy(ps, point_ring[1] + point_base, sizeof(ps));
+	memcpy(pr, point_ring[2] + point_base, sizeof(pr));
+	memcpy(pa, pressure_ring + pressure_base, sizeof(pa));
 
 	for (i = 0; i < POINT_MAX; i++) {
 		pp[0][i].all = 0;
@@ -527,7 +791,9 @@ static unsigned int CCO(unsigned int x, unsigned int coe[], int k)
 	return 0;
 }
 
-static void CoordinateCorrect(void)
+/* x (axis 0) or y (axis 1) coordinate v after the correction of the config */
+static unsigned int CoordinateCorrectAxis(struct gsl_alg_ctx *ctx, int axis,
+					  unsigned int v)
 {
 	struct MULTI_TYPE {
 		unsigned int range;
@@ -539,157 +805,129 @@ static void CoordinateCorrect(void)
 #define LINE_SIZE 4
 #endif
 	int i, j;
-	unsigned int *px[LINE_SIZE + 1], *py[LINE_SIZE + 1];
-	struct MULTI_TYPE multi_x[LINE_SIZE], multi_y[LINE_SIZE];
+	unsigned int *p[LINE_SIZE + 1];
+	struct MULTI_TYPE multi[LINE_SIZE];
 	unsigned int edge_size = 64;
-	int kx, ky;
-
-	if ((coordinate_correct_able & 0xf) == 0)
-		return;
+	unsigned int multi_array;
+	int kx, ky, k;
+
+	if (v < edge_size ||
+	    v > (axis ? sen_num_nokey : drv_num_nokey) * 64 - edge_size)
+		return v;
+	if (global_state.other.active)
+		return CCO(v, multi_group[LINE_SIZE - 2 + axis], 2);
 	kx = (coordinate_correct_able >> 4) & 0xf;
 	ky = (coordinate_correct_able >> 8) & 0xf;
-	px[0] = coordinate_correct_coe_x;
-	py[0] = coordinate_correct_coe_y;
+	k = axis ? ky : kx;
+	p[0] = axis ? coordinate_correct_coe_y : coordinate_correct_coe_x;
 	for (i = 0; i < LINE_SIZE; i++) {
-		px[i + 1] = NULL;
-		py[i + 1] = NULL;
-		multi_x[i].range = 0;
-		multi_x[i].group = 0;
-		multi_y[i].range = 0;
-		multi_y[i].group = 0;
+		p[i + 1] = NULL;
+		multi[i].range = 0;
+		multi[i].group = 0;
 	}
 	if (kx == 3 || ky == 3 || kx == 4 || ky == 4) {
-		i = 0;
-		if (kx == 3 || kx == 4)
-			px[1] = multi_group[i++];
-		if (ky == 3 || ky == 4)
-			py[1] = multi_group[i++];
+		/* the x group comes first when both axes take one */
+		i = axis && (kx == 3 || kx == 4);
+		if (k == 3 || k == 4)
+			p[1] = multi_group[i];
 	} else {
-		for (i = 0; i < LINE_SIZE; i++) {
-			multi_x[i].range = multi_x_array[i] & 0xffff;
-			multi_x[i].group = multi_x_array[i] >> 16;
-			multi_y[i].range = multi_y_array[i] & 0xffff;
-			multi_y[i].group = multi_y_array[i] >> 16;
-		}
-		j = 1;
-		for (i = 0; i < LINE_SIZE; i++)
-			if (multi_x[i].range && multi_x[i].group < LINE_SIZE)
-				px[j++] = multi_group[multi_x[i].group];
 		j = 1;
-		for (i = 0; i < LINE_SIZE; i++)
-			if (multi_y[i].range && multi_y[i].group < LINE_SIZE)
-				py[j++] = multi_group[multi_y[i].group];
+		for (i = 0; i < LINE_SIZE; i++) {
+			multi_array = axis ? multi_y_array[i] : multi_x_array[i];
+			multi[i].range = multi_array & 0xffff;
+			multi[i].group = multi_array >> 16;
+			if (multi[i].range && multi[i].group < LINE_SIZE)
+				p[j++] = multi_group[multi[i].group];
+		}
+	}
+	if ((k == 3 || k == 4) && global_state.other.cc_128)
+		return CC128(v, p, k);
+	if (k == 3)
+		return CCO(v, p[(v & 64) ? 0 : 1], 2);
+	for (j = 0; j < LINE_SIZE; j++) {
+		if (p[j + 1] == NULL || multi[j].range == 0 ||
+		    v < multi[j].range)
+			break;
+	}
+	return CCO(v, p[j], k);
+#undef LINE_SIZE
+}
+/* Expand the correction of every coordinate below CC_TABLE_SIZE, needs the
+ * config loaded and the state cleared by gsl_id_reg_init() */
+static void CoordinateCorrectInit(struct gsl_alg_ctx *ctx)
+{
+	int i;
+
+	if ((coordinate_correct_able & 0xf) == 0)
+		return;
+	for (i = 0; i < CC_TABLE_SIZE; i++) {
+		coordinate_correct_x[i] = CoordinateCorrectAxis(ctx, 0, i);
+		coordinate_correct_y[i] = CoordinateCorrectAxis(ctx, 1, i);
 	}
+}
+static void CoordinateCorrect(struct gsl_alg_ctx *ctx)
+{
+	int i;
+	unsigned int x, y;
+
+	if ((coordinate_correct_able & 0xf) == 0)
+		return;
 	for (i = 0; i < (int)point_num && i < POINT_MAX; i++) {
 		if (point_now[i].all == 0)
 			break;
 		if (point_now[i].other.key != 0)
 			continue;
-		if (point_now[i].other.x >= edge_size &&
-		    point_now[i].other.x <= drv_num_nokey * 64 - edge_size) {
-			if (global_state.other.active) {
-				point_now[i].other.x =
-					CCO(point_now[i].other.x,
-					    multi_group[LINE_SIZE - 2], 2);
-			} else if ((kx == 3 || kx == 4) &&
-				   global_state.other.cc_128) {
-				point_now[i].other.x =
-					CC128(point_now[i].other.x, px, kx);
-			} else if (kx == 3) {
-				if (point_now[i].other.x & 64)
-					point_now[i].other.x = CCO(
-						point_now[i].other.x, px[0], 2);
-				else
-					point_now[i].other.x = CCO(
-						point_now[i].other.x, px[1], 2);
-			} else {
-				for (j = 0; j < LINE_SIZE + 1; j++) {
-					if (!(j >= LINE_SIZE ||
-					      px[j + 1] == NULL ||
-					      multi_x[j].range == 0 ||
-					      point_now[i].other.x <
-						      multi_x[j].range))
-						continue;
-					point_now[i].other.x =
-						CCO(point_now[i].other.x, px[j],
-						    kx);
-					break;
-				}
-			}
-		}
-		if (point_now[i].other.y >= edge_size &&
-		    point_now[i].other.y <= sen_num_nokey * 64 - edge_size) {
-			if (global_state.other.active) {
-				point_now[i].other.y =
-					CCO(point_now[i].other.y,
-					    multi_group[LINE_SIZE - 1], 2);
-			} else if ((ky == 3 || ky == 4) &&
-				   global_state.other.cc_128) {
-				point_now[i].other.y =
-					CC128(point_now[i].other.y, py, ky);
-			} else if (ky == 3) {
-				if (point_now[i].other.y & 64)
-					point_now[i].other.y = CCO(
-						point_now[i].other.y, py[0], 2);
-				else
-					point_now[i].other.y = CCO(
-						point_now[i].other.y, py[1], 2);
-			} else {
-				for (j = 0; j < LINE_SIZE + 1; j++) {
-					if (!(j >= LINE_SIZE ||
-					      py[j + 1] == NULL ||
-					      multi_y[j].range == 0 ||
-					      point_now[i].other.y <
-						      multi_y[j].range))
-						continue;
-					point_now[i].other.y =
-						CCO(point_now[i].other.y, py[j],
-						    ky);
-					break;
-				}
-			}
+		x = point_now[i].other.x;
+		y = point_now[i].other.y;
+		if (global_state.other.active) {
+			x = CoordinateCorrectAxis(ctx, 0, x);
+			y = CoordinateCorrectAxis(ctx, 1, y);
+		} else {
+			x = x < CC_TABLE_SIZE ? coordinate_correct_x[x] :
+				CoordinateCorrectAxis(ctx, 0, x);
+			y = coordinate_correct_y[y];
 		}
+		point_now[i].other.x = x;
+		point_now[i].other.y = y;
 	}
-#undef LINE_SIZE
 }
 
-static void PointPredictOne(unsigned int n)
+static UINT PointPredictOne(struct gsl_alg_ctx *ctx, unsigned int n)
 {
-	pp[0][n].all = pp[1][n].all & FLAG_COOR;
-	pp[0][n].other.predict = 0;
+	return pp[1][n].all & FLAG_COOR;
 }
 
-static void PointPredictD2(unsigned int n)
+static UINT PointPredictD2(struct gsl_alg_ctx *ctx, unsigned int n)
 {
 	int x, y;
 
 	x = (int)pp[1][n].other.x * 2 - (int)pp[3][n].other.x;
 	y = (int)pp[1][n].other.y * 2 - (int)pp[3][n].other.y;
-	pp[0][n].all = PointRange(x, y, pp[1][n].other.x, pp[1][n].other.y);
-	pp[0][n].other.predict = 1;
+	return PointRange(ctx, x, y, pp[1][n].other.x, pp[1][n].other.y) |
+	       FLAG_PREDICT;
 }
-static void PointPredictTwo(unsigned int n)
+/* p carried on by num / den of its step from q, clipped by PointRange() */
+static UINT PointStep(struct gsl_alg_ctx *ctx, union gsl_POINT_TYPE *p,
+		      union gsl_POINT_TYPE *q, int num, int den)
 {
 	int x, y;
 
-	x = pp[1][n].other.x * 2 - pp[2][n].other.x;
-	y = pp[1][n].other.y * 2 - pp[2][n].other.y;
-	pp[0][n].all = PointRange(x, y, pp[1][n].other.x, pp[1][n].other.y);
-	pp[0][n].other.predict = 1;
+	x = ((int)p->other.x - (int)q->other.x) * num / den + (int)p->other.x;
+	y = ((int)p->other.y - (int)q->other.y) * num / den + (int)p->other.y;
+	return PointRange(ctx, x, y, p->other.x, p->other.y);
 }
 
-static void PointPredictSpeed(unsigned int n)
+static UINT PointPredictTwo(struct gsl_alg_ctx *ctx, unsigned int n)
 {
-	int x, y;
+	return PointStep(ctx, &pp[1][n], &pp[2][n], 1, 1) | FLAG_PREDICT;
+}
 
-	x = ((int)pp[1][n].other.x - (int)pp[2][n].other.x) * avg[0] / avg[1] +
-	    (int)pp[1][n].other.x;
-	y = ((int)pp[1][n].other.y - (int)pp[2][n].other.y) * avg[0] / avg[1] +
-	    (int)pp[1][n].other.y;
-	pp[0][n].all = PointRange(x, y, pp[1][n].other.x, pp[1][n].other.y);
-	pp[0][n].other.predict = 1;
+static UINT PointPredictSpeed(struct gsl_alg_ctx *ctx, unsigned int n)
+{
+	return PointStep(ctx, &pp[1][n], &pp[2][n], avg[0], avg[1]) |
+	       FLAG_PREDICT;
 }
-static void PointPredictD3(unsigned int n)
+static UINT PointPredictD3(struct gsl_alg_ctx *ctx, unsigned int n)
 {
 	int x, y;
 
@@ -699,11 +937,11 @@ static void PointPredictD3(unsigned int n)
 	y = (int)pp[1][n].other.y * 5 + (int)pp[5][n].other.y -
 	    (int)pp[3][n].other.y * 4;
 	y /= 2;
-	pp[0][n].all = PointRange(x, y, pp[1][n].other.x, pp[1][n].other.y);
-	pp[0][n].other.predict = 1;
+	return PointRange(ctx, x, y, pp[1][n].other.x, pp[1][n].other.y) |
+	       FLAG_PREDICT;
 }
 
-static void PointPredictThree(unsigned int n)
+static UINT PointPredictThree(struct gsl_alg_ctx *ctx, unsigned int n)
 {
 	int x, y;
 
@@ -711,105 +949,186 @@ static void PointPredictThree(unsigned int n)
 	x /= 2;
 	y = pp[1][n].other.y * 5 + pp[3][n].other.y - pp[2][n].other.y * 4;
 	y /= 2;
-	pp[0][n].all = PointRange(x, y, pp[1][n].other.x, pp[1][n].other.y);
-	pp[0][n].other.predict = 1;
+	return PointRange(ctx, x, y, pp[1][n].other.x, pp[1][n].other.y) |
+	       FLAG_PREDICT;
 }
 
-static void PointPredict(void)
+/* Each point is built in a register and stored once, flags included */
+static void PointPredict(struct gsl_alg_ctx *ctx)
 {
 	int i;
+	UINT p;
 
 	for (i = 0; i < POINT_MAX; i++) {
-		if (pp[1][i].all != 0) {
-			if (global_state.other.interpolation != 0 &&
-			    global_state.other.interpolation != INTE_INIT &&
-			    pp[3][i].all && pp[3][i].other.fill == 0) {
-				if (pp[4][i].all && pp[5][i].all &&
-				    pp[5][i].other.fill == 0)
-					PointPredictD3(i);
-				else
-					PointPredictD2(i);
-			} else if (global_state.other.interpolation ||
-				   pp[2][i].all == 0 ||
-				   pp[2][i].other.fill != 0 ||
-				   pp[3][i].other.fill != 0 ||
-				   pp[1][i].other.key != 0 ||
-				   global_state.other.only) {
-				PointPredictOne(i);
-			} else if (pp[2][i].all != 0 &&
-				   (avg[0] != avg[1] || avg[1] != avg[2]) &&
-				   avg[0] != 0 && avg[1] != 0) {
-				PointPredictSpeed(i);
-			} else if (pp[2][i].all != 0) {
-				if (pp[3][i].all != 0)
-					PointPredictThree(i);
-				else
-					PointPredictTwo(i);
-			}
-			pp[0][i].all |= FLAG_FILL;
-			pa[0][i] = pa[1][i];
-		} else
+		if (pp[1][i].all == 0) {
 			pp[0][i].all = 0x0fff0fff;
-		if (pp[1][i].other.key)
-			pp[0][i].all |= FLAG_KEY;
+			continue;
+		}
+		if (global_state.other.interpolation != 0 &&
+		    global_state.other.interpolation != INTE_INIT &&
+		    pp[3][i].all && pp[3][i].other.fill == 0) {
+			if (pp[4][i].all && pp[5][i].all &&
+			    pp[5][i].other.fill == 0)
+				p = PointPredictD3(ctx, i);
+			else
+				p = PointPredictD2(ctx, i);
+		} else if (global_state.other.interpolation ||
+			   pp[2][i].all == 0 || pp[2][i].other.fill != 0 ||
+			   pp[3][i].other.fill != 0 ||
+			   pp[1][i].other.key != 0 ||
+			   global_state.other.only) {
+			p = PointPredictOne(ctx, i);
+		} else if ((avg[0] != avg[1] || avg[1] != avg[2]) &&
+			   avg[0] != 0 && avg[1] != 0) {
+			p = PointPredictSpeed(ctx, i);
+		} else if (pp[3][i].all != 0) {
+			p = PointPredictThree(ctx, i);
+		} else {
+			p = PointPredictTwo(ctx, i);
+		}
+		pp[0][i].all = p | FLAG_FILL | (pp[1][i].all & FLAG_KEY);
+		pa[0][i] = pa[1][i];
 	}
 }
 
-static unsigned int PointDistance(union gsl_POINT_TYPE *p1,
-				  union gsl_POINT_TYPE *p2)
+/*
+ * Truncating division by an invariant d > 0 as a multiply and shift
+ * (Granlund and Montgomery): with l = ceil(log2(d)) and
+ * m = floor(2^(31 + l) / d) + 1, n / d == (n * m) >> (31 + l) for every
+ * 0 <= n < 2^31. Negative n uses the magnitude, as C division does; other
+ * divisors and INT_MIN fall back to the divide instruction.
+ */
+static void RecipInit(struct gsl_RECIP_TYPE *p, int d)
+{
+	unsigned int l = 0;
+
+	p->d = d;
+	p->m = 0;
+	p->s = 0;
+	if (d <= 0)
+		return;
+	while ((1ull << l) < (unsigned int)d)
+		l++;
+	p->s = 31 + l;
+	p->m = (unsigned int)((1ull << p->s) / (unsigned int)d + 1);
+}
+
+static inline int RecipDiv(const struct gsl_RECIP_TYPE *p, int n)
 {
-	int a, b, ret;
+	unsigned int u = n < 0 ? 0u - (unsigned int)n : (unsigned int)n;
+
+	if (p->m == 0 || (u >> 31))
+		return n / p->d;
+	u = (unsigned int)(((unsigned long long)u * p->m) >> p->s);
+	return n < 0 ? -(int)u : (int)u;
+}
 
+/*
+ * Distances are taken on the dis coordinates, with reso_y (or reso_x) set the
+ * y (or x) axis is first brought to the scale of the other one:
+ * v * 64 * screen_max / screen_max_other * (64 * electrodes) /
+ * (64 * electrodes_other) / 64, truncated after each division. The factors
+ * are set up by DistanceScaleInit().
+ */
+static void DistanceScaleInit(struct gsl_alg_ctx *ctx)
+{
 	if (id_flag.other.reso_y) {
-		a = p1->dis.x;
-		b = p2->dis.x;
-		ret = (a - b) * (a - b);
-		a = p1->dis.y * 64 * (int)screen_y_max / (int)screen_x_max *
-		    ((int)drv_num_nokey * 64) / ((int)sen_num_nokey * 64) / 64;
-		b = p2->dis.y * 64 * (int)screen_y_max / (int)screen_x_max *
-		    ((int)drv_num_nokey * 64) / ((int)sen_num_nokey * 64) / 64;
-		ret += (a - b) * (a - b);
+		dis_scale_mul = 64 * (int)screen_y_max;
+		RecipInit(&dis_scale_div, (int)screen_x_max);
+		dis_grid_mul = (int)drv_num_nokey * 64;
+		RecipInit(&dis_grid_div, (int)sen_num_nokey * 64);
 	} else if (id_flag.other.reso_x) {
-		a = p1->dis.x * 64 * (int)screen_x_max / (int)screen_y_max *
-		    ((int)sen_num_nokey * 64) / ((int)drv_num_nokey * 64) / 64;
-		b = p2->dis.x * 64 * (int)screen_x_max / (int)screen_y_max *
-		    ((int)sen_num_nokey * 64) / ((int)drv_num_nokey * 64) / 64;
-		ret = (a - b) * (a - b);
-		a = p1->dis.y;
-		b = p2->dis.y;
-		ret += (a - b) * (a - b);
-	} else {
-		a = p1->dis.x;
-		b = p2->dis.x;
-		ret = (a - b) * (a - b);
-		a = p1->dis.y;
-		b = p2->dis.y;
-		ret += (a - b) * (a - b);
+		dis_scale_mul = 64 * (int)screen_x_max;
+		RecipInit(&dis_scale_div, (int)screen_y_max);
+		dis_grid_mul = (int)sen_num_nokey * 64;
+		RecipInit(&dis_grid_div, (int)drv_num_nokey * 64);
 	}
-	return ret;
 }
 
+static inline int DistanceScale(struct gsl_alg_ctx *ctx, int v)
+{
+	return RecipDiv(&dis_grid_div,
+			RecipDiv(&dis_scale_div, v * dis_scale_mul) *
+				dis_grid_mul) / 64;
+}
+
+static inline void PointScale(struct gsl_alg_ctx *ctx,
+			      union gsl_POINT_TYPE *p, int *x, int *y)
+{
+	*x = p->dis.x;
+	*y = p->dis.y;
+	if (id_flag.other.reso_y)
+		*y = DistanceScale(ctx, *y);
+	else if (id_flag.other.reso_x)
+		*x = DistanceScale(ctx, *x);
+}
+
+static unsigned int PointDistance(struct gsl_alg_ctx *ctx, union gsl_POINT_TYPE *p1,
+				  union gsl_POINT_TYPE *p2)
+{
+	int x1, y1, x2, y2;
+
+	PointScale(ctx, p1, &x1, &y1);
+	PointScale(ctx, p2, &x2, &y2);
+	return (x1 - x2) * (x1 - x2) + (y1 - y2) * (y1 - y2);
+}
+
+/* Distances from (x, y) to all POINT_MAX scaled points, as PointDistance() */
+static void PointDistanceRow(int x, int y, const int *xs, const int *ys,
+			     unsigned int *d)
+{
+	int i;
+
+	for (i = 0; i < POINT_MAX; i++)
+		d[i] = (x - xs[i]) * (x - xs[i]) + (y - ys[i]) * (y - ys[i]);
+}
+
+/*
+ * Greedy matching of new points (rows) to tracked slots (columns): take the
+ * smallest distance, first in row-major order on ties, drop its row and
+ * column, repeat. Each row caches its minimum over the remaining columns, so
+ * a pick scans the rows only and a drop rescans just the rows whose minimum
+ * sat in the dropped column; only rows and columns in use are ever visited.
+ */
 static void DistanceInit(struct gsl_DISTANCE_TYPE *p)
+{
+	p->rows = 0;
+	p->cols = 0;
+}
+
+static void DistanceRow(struct gsl_DISTANCE_TYPE *p, int j)
 {
 	int i;
-	unsigned int *p_int = &(p->d[0][0]);
 
-	for (i = 0; i < POINT_MAX * POINT_MAX; i++)
-		*p_int++ = 0x7fffffff;
+	p->row_min[j] = 0x7fffffff;
+	for (i = 0; i < POINT_MAX; i++) {
+		if ((p->cols & (1u << i)) && p->d[j][i] < p->row_min[j]) {
+			p->row_min[j] = p->d[j][i];
+			p->row_arg[j] = i;
+		}
+	}
+}
+
+/* Call once all distances are in, before the first DistanceMin() */
+static void DistanceRows(struct gsl_DISTANCE_TYPE *p)
+{
+	int j;
+
+	for (j = 0; j < POINT_MAX; j++)
+		if (p->rows & (1u << j))
+			DistanceRow(p, j);
 }
 
 static int DistanceMin(struct gsl_DISTANCE_TYPE *p)
 {
-	int i, j;
+	int j;
 
 	p->min = 0x7fffffff;
 	for (j = 0; j < POINT_MAX; j++) {
-		for (i = 0; i < POINT_MAX; i++) {
-			if (p->d[j][i] < p->min) {
-				p->i = i;
-				p->j = j;
-				p->min = p->d[j][i];
-			}
+		if ((p->rows & (1u << j)) && p->row_min[j] < p->min) {
+			p->i = p->row_arg[j];
+			p->j = j;
+			p->min = p->row_min[j];
 		}
 	}
 	if (p->min == 0x7fffffff)
@@ -819,12 +1138,14 @@ static int DistanceMin(struct gsl_DISTANCE_TYPE *p)
 
 static void DistanceIgnore(struct gsl_DISTANCE_TYPE *p)
 {
-	int i, j;
+	int j;
 
-	for (i = 0; i < POINT_MAX; i++)
-		p->d[p->j][i] = 0x7fffffff;
+	p->rows &= ~(1u << p->j);
+	p->cols &= ~(1u << p->i);
 	for (j = 0; j < POINT_MAX; j++)
-		p->d[j][p->i] = 0x7fffffff;
+		if ((p->rows & (1u << j)) && p->row_arg[j] == p->i &&
+		    p->row_min[j] != 0x7fffffff)
+			DistanceRow(p, j);
 }
 
 static int SpeedGet(int d)
@@ -838,11 +1159,12 @@ static int SpeedGet(int d)
 	return i;
 }
 
-static void PointId(void)
+static void PointId(struct gsl_alg_ctx *ctx)
 {
 	int i, j;
 	struct gsl_DISTANCE_TYPE distance;
 	unsigned int id_speed[POINT_MAX];
+	int now_x, now_y, pp_x[POINT_MAX], pp_y[POINT_MAX];
 
 	DistanceInit(&distance);
 	for (i = 0; i < POINT_MAX; i++) {
@@ -850,21 +1172,31 @@ static void PointId(void)
 			id_speed[i] = id_first_coe;
 		else {
 			id_speed[i] =
-				SpeedGet(PointDistance(&pp[1][i], &pp[0][i]));
-			j = SpeedGet(PointDistance(&pp[2][i], &pp[1][i]));
+				SpeedGet(PointDistance(ctx, &pp[1][i], &pp[0][i]));
+			j = SpeedGet(PointDistance(ctx, &pp[2][i], &pp[1][i]));
 			if (id_speed[i] < (unsigned int)j)
 				id_speed[i] = j;
 		}
 	}
+	for (j = 0; j < point_num && j < POINT_MAX; j++)
+		distance.rows |= 1u << j;
+	/* Scale every point once, then fill whole rows; the columns of free
+	 * slots are computed too but never read */
 	for (i = 0; i < POINT_MAX; i++) {
-		if (pp[0][i].all == FLAG_COOR)
+		if (pp[0][i].all == FLAG_COOR) {
+			pp_x[i] = pp_y[i] = 0;
 			continue;
-		for (j = 0; j < point_num && j < POINT_MAX; j++)
-			distance.d[j][i] =
-				PointDistance(&point_now[j], &pp[0][i]);
+		}
+		distance.cols |= 1u << i;
+		PointScale(ctx, &pp[0][i], &pp_x[i], &pp_y[i]);
+	}
+	for (j = 0; j < point_num && j < POINT_MAX; j++) {
+		PointScale(ctx, &point_now[j], &now_x, &now_y);
+		PointDistanceRow(now_x, now_y, pp_x, pp_y, distance.d[j]);
 	}
 	if (point_num == 0)
 		return;
+	DistanceRows(&distance);
 	if (global_state.other.only || global_state.other.active) {
 		do {
 			if (DistanceMin(&distance)) {
@@ -900,7 +1232,7 @@ static void PointId(void)
 	}
 }
 
-static int ClearLenPP(int i)
+static int ClearLenPP(struct gsl_alg_ctx *ctx, int i)
 {
 	int n;
 
@@ -911,7 +1243,7 @@ static int ClearLenPP(int i)
 	return n;
 }
 
-static void PointNewId(void)
+static void PointNewId(struct gsl_alg_ctx *ctx)
 {
 	int id, j;
 
@@ -923,7 +1255,7 @@ static void PointNewId(void)
 			if (point_now[j].other.able)
 				continue;
 			for (id = 1; id <= POINT_MAX; id++) {
-				if (ClearLenPP(id - 1) > (int)(1 + 1)) {
+				if (ClearLenPP(ctx, id - 1) > (int)(1 + 1)) {
 					pp[0][id - 1].all = point_now[j].all;
 					pa[0][id - 1] = pressure_now[j];
 					point_now[j].all = 0;
@@ -934,7 +1266,7 @@ static void PointNewId(void)
 	}
 }
 
-static void PointOrder(void)
+static void PointOrder(struct gsl_alg_ctx *ctx)
 {
 	int i;
 
@@ -949,16 +1281,20 @@ static void PointOrder(void)
 	}
 }
 
-static void PointCross(void)
+static void PointCross(struct gsl_alg_ctx *ctx)
 {
 	unsigned int i, j;
 	unsigned int t;
-
-	for (j = 0; j < POINT_MAX; j++) {
-		for (i = j + 1; i < POINT_MAX; i++) {
-			if (pp[0][i].all == 0 || pp[0][j].all == 0 ||
-			    pp[1][i].all == 0 || pp[1][j].all == 0)
-				continue;
+	unsigned int both = 0, mj, mi;
+
+	/* only pairs with both points in this frame and the last */
+	for (mj = point_mask; mj; mj &= mj - 1)
+		if (pp[1][__builtin_ctz(mj)].all != 0)
+			both |= mj & -mj;
+	for (mj = both; mj; mj &= mj - 1) {
+		j = __builtin_ctz(mj);
+		for (mi = mj & (mj - 1); mi; mi &= mi - 1) {
+			i = __builtin_ctz(mi);
 			if (((pp[0][j].other.x < pp[0][i].other.x &&
 			      pp[1][j].other.x > pp[1][i].other.x) ||
 			     (pp[0][j].other.x > pp[0][i].other.x &&
@@ -978,17 +1314,72 @@ static void PointCross(void)
 	}
 }
 
-static void GetPointNum(union gsl_POINT_TYPE *pt)
+static void GetPointNum(struct gsl_alg_ctx *ctx, union gsl_POINT_TYPE *pt)
 {
-	int i;
+	unsigned int m = 0;
+	int i, n = 0;
 
-	point_num = 0;
-	for (i = 0; i < POINT_MAX; i++)
-		if (pt[i].all != 0)
-			point_num++;
+	for (i = 0; i < POINT_MAX; i++) {
+		m |= (unsigned int)(pt[i].all != 0) << i;
+		n += pt[i].all != 0;
+	}
+	point_mask = m;
+	point_num = n;
+}
+
+/* Fastest step of slot i over its last seen points. Read from pp, as
+ * PointStretch() refills and holds back ps of a finger this young and
+ * FilterSpeed() would find it still. */
+static unsigned int PointDelaySpeed(struct gsl_alg_ctx *ctx, int i, int seen)
+{
+	unsigned int speed = 0, d;
+	int j;
+
+	for (j = 1; j < seen; j++) {
+		d = PointDistance(ctx, &pp[j - 1][i], &pp[j][i]);
+		if (d > speed)
+			speed = d;
+	}
+	return Sqrt(speed);
+}
+
+/* A held finger seen for seen frames, all real points, that moves no faster
+ * than the still noise of the reported fingers */
+static unsigned int PointDelaySettled(struct gsl_alg_ctx *ctx, int i, int seen)
+{
+	unsigned int still;
+
+	if (seen < DELAY_SEEN_MIN || pp[seen][i].all != 0 ||
+	    pp[0][i].other.key)
+		return FALSE;
+	/* steps across a change of the scan interval do not compare */
+	if (avg[0] != avg[1] && avg[0] != 0 && avg[1] != 0) {
+		delay_stat.unsteady++;
+		return FALSE;
+	}
+	still = delay_stat.noise * 2 / 16;
+	if (still < DELAY_STILL_MIN)
+		still = DELAY_STILL_MIN;
+	if (still > DELAY_STILL_MAX)
+		still = DELAY_STILL_MAX;
+	return PointDelaySpeed(ctx, i, seen) <= still;
 }
 
-static unsigned int PointDelayAvg(int i)
+/* Shorten the delay of slot i, report and dele keep their distance to it */
+static void PointDelayCut(struct gsl_alg_ctx *ctx, int i, unsigned int delay)
+{
+	unsigned int cut = point_delay[i].other.delay - delay;
+
+	point_delay[i].other.delay = delay;
+	point_delay[i].other.report = point_delay[i].other.report > cut
+					      ? point_delay[i].other.report - cut
+					      : 0;
+	point_delay[i].other.dele = point_delay[i].other.dele > cut
+					    ? point_delay[i].other.dele - cut
+					    : 0;
+}
+
+static unsigned int PointDelayAvg(struct gsl_alg_ctx *ctx, int i)
 {
 	UINT j, len;
 	int sum_x = 0;
@@ -1039,9 +1430,16 @@ static unsigned int PointDelayAvg(int i)
 	}
 	return TRUE;
 }
-static void PointDelay(void)
+static void PointDelay(struct gsl_alg_ctx *ctx)
 {
-	int i, j;
+	int i, j, early;
+	unsigned int speed, m;
+
+	/* held in the last frame and lifted since */
+	for (m = delay_held; m; m &= m - 1)
+		if (pp[0][__builtin_ctz(m)].all == 0)
+			delay_stat.dropped++;
+	delay_held = 0;
 
 	for (i = 0; i < POINT_MAX; i++) {
 		if (report_delay == 0 && delay_key == 0) {
@@ -1104,7 +1502,7 @@ static void PointDelay(void)
 		if (id_flag.other.first_avg && pp[0][i].all == 0 &&
 		    pp[1][i].all != 0 && point_delay[i].other.able == 0 &&
 		    point_delay[i].other.init != 0) {
-			if (PointDelayAvg(i)) {
+			if (PointDelayAvg(ctx, i)) {
 				point_delay[i].other.able = 1;
 				point_delay[i].other.report = 1;
 				point_delay[i].other.dele = 1;
@@ -1122,12 +1520,25 @@ static void PointDelay(void)
 				    pp[j][i].other.able != 0)
 					break;
 			}
-			if (j <= (int)point_delay[i].other.delay)
-				continue;
-			if (PointDelayAvg(i))
+			early = j <= (int)point_delay[i].other.delay;
+			if (early) {
+				if (adaptive_delay == 0 ||
+				    !PointDelaySettled(ctx, i, j)) {
+					delay_stat.held++;
+					delay_held |= 0x1 << i;
+					continue;
+				}
+				PointDelayCut(ctx, i, j - 1);
+			}
+			if (PointDelayAvg(ctx, i)) {
 				point_delay[i].other.able = 1;
-			else
+				if (early)
+					delay_stat.early++;
+				else
+					delay_stat.released++;
+			} else {
 				j = 0;
+			}
 			if (id_flag.other.first_avg)
 				point_delay[i].other.report =
 					point_delay[i].other.dele;
@@ -1139,8 +1550,17 @@ static void PointDelay(void)
 		}
 		if (point_delay[i].other.able == 0)
 			continue;
+		/* still noise for PointDelaySettled(), 1/16 units, fast
+		 * fingers are moving rather than shaking */
+		if (adaptive_delay && pp[0][i].other.key == 0 && pp[1][i].all) {
+			speed = PointDistance(ctx, &pp[0][i], &pp[1][i]);
+			if (speed < DELAY_STILL_MAX * DELAY_STILL_MAX)
+				delay_stat.noise = (delay_stat.noise * 15 +
+						    Sqrt(speed) * 16) /
+						   16;
+		}
 		if (report_delete == 0 && point_delay[i].other.report) {
-			if (PointDistance(
+			if (PointDistance(ctx,
 				    &pp[point_delay[i].other.report][i],
 				    &pp[point_delay[i].other.report - 1][i]) <
 			    3 * 3) {
@@ -1152,7 +1572,7 @@ static void PointDelay(void)
 	}
 }
 
-static unsigned int PointMOne(unsigned int x0, unsigned int x1)
+static unsigned int PointMOne(struct gsl_alg_ctx *ctx, unsigned int x0, unsigned int x1)
 {
 	int e1, e2;
 
@@ -1171,7 +1591,7 @@ static unsigned int PointMOne(unsigned int x0, unsigned int x1)
 	return 0;
 }
 
-static void PointMenu(void)
+static void PointMenu(struct gsl_alg_ctx *ctx)
 {
 	unsigned int edge_dis;
 	unsigned int edge_e;
@@ -1189,15 +1609,15 @@ static void PointMenu(void)
 	edge_e = edge_start & 0xff;
 	edge_dis = (edge_start & 0xff00) >> 8;
 	edge_dis = edge_dis == 0 ? 8 * 8 : edge_dis * edge_dis;
-	if (PointDistance(&pp[0][0], &pp[1][0]) >= edge_dis) {
-		if (PointMOne(pp[0][0].other.x, pp[1][0].other.x))
+	if (PointDistance(ctx, &pp[0][0], &pp[1][0]) >= edge_dis) {
+		if (PointMOne(ctx, pp[0][0].other.x, pp[1][0].other.x))
 			pr[1][0].other.x = 1;
-		if (PointMOne(pp[0][0].other.y, pp[1][0].other.y))
+		if (PointMOne(ctx, pp[0][0].other.y, pp[1][0].other.y))
 			pr[1][0].other.y = 1;
-		if (PointMOne(drv_num_nokey * 64 - pp[0][0].other.x,
+		if (PointMOne(ctx, drv_num_nokey * 64 - pp[0][0].other.x,
 			      drv_num_nokey * 64 - pp[1][0].other.x))
 			pr[1][0].other.x = drv_num_nokey * 64 - 1;
-		if (PointMOne(sen_num_nokey * 64 - pp[0][0].other.y,
+		if (PointMOne(ctx, sen_num_nokey * 64 - pp[0][0].other.y,
 			      sen_num_nokey * 64 - pp[1][0].other.y))
 			pr[1][0].other.y = sen_num_nokey * 64 - 1;
 	} else if (global_state.other.menu == 0) {
@@ -1213,24 +1633,67 @@ static void PointMenu(void)
 	}
 }
 
-static void FilterOne(int i, int *ps_c, int *pr_c, int denominator)
+static void FilterTaps(struct gsl_alg_ctx *ctx, struct gsl_FIR_TYPE *fir,
+		       const int *ps_c, const int *pr_c, int denominator)
+{
+	int j;
+
+	fir->num = 0;
+	for (j = 0; j < 8; j++) {
+		if (pr_c[j]) {
+			fir->row[fir->num] = &pr[j];
+			fir->coe[fir->num++] = pr_c[j];
+		}
+		if (ps_c[j]) {
+			fir->row[fir->num] = &ps[j];
+			fir->coe[fir->num++] = ps_c[j];
+		}
+	}
+	RecipInit(&fir->den, denominator);
+}
+/* Decode the coefficients PointFilter() runs FilterOne() with */
+static void FilterInit(struct gsl_alg_ctx *ctx)
+{
+	int i;
+	int ps_c[8];
+	int pr_c[8];
+
+	if (filter_able > 1) {
+		for (i = 0; i < 8; i++) {
+			ps_c[i] = (filter_coe[i / 4] >> ((i % 4) * 8)) & 0xff;
+			pr_c[i] =
+				(filter_coe[i / 4 + 2] >> ((i % 4) * 8)) & 0xff;
+			if (ps_c[i] >= 0x80)
+				ps_c[i] |= 0xffffff00;
+			if (pr_c[i] >= 0x80)
+				pr_c[i] |= 0xffffff00;
+		}
+		FilterTaps(ctx, &filter_fir[0], ps_c, pr_c, filter_able);
+	} else if (filter_able < -1) {
+		for (i = 0; i < 4; i++)
+			FilterTaps(ctx, &filter_fir[i], ps_coe[i], pr_coe[i],
+				   0 - filter_able);
+	}
+}
+static void FilterOne(struct gsl_alg_ctx *ctx, int i,
+		      const struct gsl_FIR_TYPE *fir)
 {
 	int j;
 	int x = 0, y = 0;
+	union gsl_POINT_TYPE *p;
 
 	pr[0][i].all = ps[0][i].all;
 	if (pr[0][i].all == 0)
 		return;
-	if (denominator <= 0)
+	if (fir->den.d <= 0)
 		return;
-	for (j = 0; j < 8; j++) {
-		x += (int)pr[j][i].other.x * (int)pr_c[j] +
-		     (int)ps[j][i].other.x * (int)ps_c[j];
-		y += (int)pr[j][i].other.y * (int)pr_c[j] +
-		     (int)ps[j][i].other.y * (int)ps_c[j];
+	for (j = 0; j < fir->num; j++) {
+		p = &(*fir->row[j])[i];
+		x += (int)p->other.x * fir->coe[j];
+		y += (int)p->other.y * fir->coe[j];
 	}
-	x = (x + denominator / 2) / denominator;
-	y = (y + denominator / 2) / denominator;
+	x = RecipDiv(&fir->den, x + fir->den.d / 2);
+	y = RecipDiv(&fir->den, y + fir->den.d / 2);
 	if (x < 0)
 		x = 0;
 	if (x > 0xffff)
@@ -1243,14 +1706,14 @@ static void FilterOne(int i, int *ps_c, int *pr_c, int denominator)
 	pr[0][i].other.y = y;
 }
 
-static unsigned int FilterSpeed(int i)
+static unsigned int FilterSpeed(struct gsl_alg_ctx *ctx, int i)
 {
-	return (Sqrt(PointDistance(&ps[0][i], &ps[1][i])) +
-		Sqrt(PointDistance(&ps[1][i], &ps[2][i]))) /
+	return (Sqrt(PointDistance(ctx, &ps[0][i], &ps[1][i])) +
+		Sqrt(PointDistance(ctx, &ps[1][i], &ps[2][i]))) /
 	       2;
 }
 
-static int MedianSpeedOver(int id, int deep)
+static int MedianSpeedOver(struct gsl_alg_ctx *ctx, int id, int deep)
 {
 	int i;
 	unsigned int dis;
@@ -1261,7 +1724,7 @@ static int MedianSpeedOver(int id, int deep)
 		return TRUE;
 	dis = median_dis[deep] * median_dis[deep];
 	for (i = 0; i <= deep && i < POINT_DEEP; i++) {
-		if (PointDistance(&ps[i][id], &ps[i + 1][id]) > dis)
+		if (PointDistance(ctx, &ps[i][id], &ps[i + 1][id]) > dis)
 			speed_over++;
 	}
 	if (speed_over >= 2)
@@ -1269,11 +1732,115 @@ static int MedianSpeedOver(int id, int deep)
 	return FALSE;
 }
 
-static void PointMedian(void)
+/*
+ * Median selection networks for 3, 5, 7 and 9 samples (Paeth, Devillard):
+ * each MEDIAN_CX orders one pair, and only the exchanges that can still
+ * move the middle element are kept. MEDIAN_LANES runs the same network on
+ * both axes of a point, lane 0 is x and lane 1 is y.
+ */
+#define MEDIAN_CX(a, b)                                    \
+	do {                                               \
+		int lo_ = (a) < (b) ? (a) : (b);           \
+		(b) = (a) < (b) ? (b) : (a);               \
+		(a) = lo_;                                 \
+	} while (0)
+
+#define MEDIAN_LANES(v, a, b)                              \
+	do {                                               \
+		MEDIAN_CX(v[a][0], v[b][0]);               \
+		MEDIAN_CX(v[a][1], v[b][1]);               \
+	} while (0)
+
+static void MedianNet3(int v[][2])
+{
+	MEDIAN_LANES(v, 0, 1);
+	MEDIAN_LANES(v, 1, 2);
+	MEDIAN_LANES(v, 0, 1);
+}
+
+static void MedianNet5(int v[][2])
+{
+	MEDIAN_LANES(v, 0, 1);
+	MEDIAN_LANES(v, 3, 4);
+	MEDIAN_LANES(v, 0, 3);
+	MEDIAN_LANES(v, 1, 4);
+	MEDIAN_LANES(v, 1, 2);
+	MEDIAN_LANES(v, 2, 3);
+	MEDIAN_LANES(v, 1, 2);
+}
+
+static void MedianNet7(int v[][2])
+{
+	MEDIAN_LANES(v, 0, 5);
+	MEDIAN_LANES(v, 0, 3);
+	MEDIAN_LANES(v, 1, 6);
+	MEDIAN_LANES(v, 2, 4);
+	MEDIAN_LANES(v, 0, 1);
+	MEDIAN_LANES(v, 3, 5);
+	MEDIAN_LANES(v, 2, 6);
+	MEDIAN_LANES(v, 2, 3);
+	MEDIAN_LANES(v, 3, 6);
+	MEDIAN_LANES(v, 4, 5);
+	MEDIAN_LANES(v, 1, 4);
+	MEDIAN_LANES(v, 1, 3);
+	MEDIAN_LANES(v, 3, 4);
+}
+
+static void MedianNet9(int v[][2])
+{
+	MEDIAN_LANES(v, 1, 2);
+	MEDIAN_LANES(v, 4, 5);
+	MEDIAN_LANES(v, 7, 8);
+	MEDIAN_LANES(v, 0, 1);
+	MEDIAN_LANES(v, 3, 4);
+	MEDIAN_LANES(v, 6, 7);
+	MEDIAN_LANES(v, 1, 2);
+	MEDIAN_LANES(v, 4, 5);
+	MEDIAN_LANES(v, 7, 8);
+	MEDIAN_LANES(v, 0, 3);
+	MEDIAN_LANES(v, 5, 8);
+	MEDIAN_LANES(v, 4, 7);
+	MEDIAN_LANES(v, 3, 6);
+	MEDIAN_LANES(v, 1, 4);
+	MEDIAN_LANES(v, 2, 5);
+	MEDIAN_LANES(v, 4, 7);
+	MEDIAN_LANES(v, 4, 2);
+	MEDIAN_LANES(v, 6, 4);
+	MEDIAN_LANES(v, 4, 2);
+}
+
+/* median of the last deep ps[] samples of one slot, x and y together */
+static void MedianOne(struct gsl_alg_ctx *ctx, int i, int deep)
+{
+	int p[9][2];
+	int j;
+
+	for (j = 0; j < deep; j++) {
+		p[j][0] = ps[j][i].other.x;
+		p[j][1] = ps[j][i].other.y;
+	}
+	switch (deep) {
+	case 3:
+		MedianNet3(p);
+		break;
+	case 5:
+		MedianNet5(p);
+		break;
+	case 7:
+		MedianNet7(p);
+		break;
+	default:
+		MedianNet9(p);
+		break;
+	}
+	pr[0][i].other.x = p[deep / 2][0];
+	pr[0][i].other.y = p[deep / 2][1];
+}
+
+static void PointMedian(struct gsl_alg_ctx *ctx)
 {
-	int i, j;
+	int i;
 	int deep;
-	int buf_x[PS_DEEP], buf_y[PS_DEEP];
 
 	for (i = 0; i < POINT_MAX; i++) {
 		if (filter_deep[i] < 3)
@@ -1283,36 +1850,35 @@ static void PointMedian(void)
 		if (deep >= PS_DEEP)
 			deep = PS_DEEP - 1;
 		deep |= 1;
+		/* MedianSpeedOver() rejects anything past 9 samples */
 		for (; deep >= 3; deep -= 2) {
-			if (MedianSpeedOver(i, deep))
+			if (MedianSpeedOver(ctx, i, deep))
 				continue;
-			for (j = 0; j < deep; j++) {
-				buf_x[j] = ps[j][i].other.x;
-				buf_y[j] = ps[j][i].other.y;
-			}
-			SortBubble(buf_x, deep);
-			SortBubble(buf_y, deep);
-			pr[0][i].other.x = buf_x[deep / 2];
-			pr[0][i].other.y = buf_y[deep / 2];
+			MedianOne(ctx, i, deep);
 			break;
 		}
 		filter_deep[i] = deep;
 	}
 }
 
-static void PointFilter(void)
+static void PointFilter(struct gsl_alg_ctx *ctx)
 {
 	int i, j;
 	int speed_now;
 	int filter_speed[6];
-	int ps_c[8];
-	int pr_c[8];
+	unsigned int set = 0, m;
 
-	for (i = 0; i < POINT_MAX; i++)
+	/* PointStretch() only set ps[0] within point_mask, pr[0] is clear */
+	for (m = point_mask; m; m &= m - 1) {
+		i = __builtin_ctz(m);
 		pr[0][i].all = ps[0][i].all;
+		if (pr[0][i].all)
+			set |= 0x1 << i;
+	}
 
-	for (i = 0; i < POINT_MAX; i++) {
-		if (pr[0][i].all != 0 && pr[1][i].all == 0) {
+	for (m = set; m; m &= m - 1) {
+		i = __builtin_ctz(m);
+		if (pr[1][i].all == 0) {
 			for (j = 1; j < PR_DEEP; j++)
 				pr[j][i].all = ps[0][i].all;
 			for (j = 1; j < PS_DEEP; j++)
@@ -1322,20 +1888,12 @@ static void PointFilter(void)
 	if (filter_able >= 0 && filter_able <= 1)
 		return;
 	if (filter_able > 1) {
-		for (i = 0; i < 8; i++) {
-			ps_c[i] = (filter_coe[i / 4] >> ((i % 4) * 8)) & 0xff;
-			pr_c[i] =
-				(filter_coe[i / 4 + 2] >> ((i % 4) * 8)) & 0xff;
-			if (ps_c[i] >= 0x80)
-				ps_c[i] |= 0xffffff00;
-			if (pr_c[i] >= 0x80)
-				pr_c[i] |= 0xffffff00;
-		}
-		for (i = 0; i < POINT_MAX; i++)
-			FilterOne(i, ps_c, pr_c, filter_able);
+		/* FilterOne() leaves an empty slot as it is */
+		for (m = set; m; m &= m - 1)
+			FilterOne(ctx, __builtin_ctz(m), &filter_fir[0]);
 
 	} else if (filter_able == -1) {
-		PointMedian();
+		PointMedian(ctx);
 	} else if (filter_able < 0) {
 		for (i = 0; i < 4; i++)
 			filter_speed[i + 1] = median_dis[i];
@@ -1346,7 +1904,7 @@ static void PointFilter(void)
 				filter_deep[i] = 0;
 				continue;
 			}
-			speed_now = FilterSpeed(i);
+			speed_now = FilterSpeed(ctx, i);
 			if (filter_deep[i] > 0 &&
 			    speed_now > filter_speed[filter_deep[i] + 1 - 2])
 				filter_deep[i]--;
@@ -1355,13 +1913,12 @@ static void PointFilter(void)
 					 filter_speed[filter_deep[i] + 1 + 2])
 				filter_deep[i]++;
 
-			FilterOne(i, ps_coe[filter_deep[i]],
-				  pr_coe[filter_deep[i]], 0 - filter_able);
+			FilterOne(ctx, i, &filter_fir[filter_deep[i]]);
 		}
 	}
 }
 
-static unsigned int KeyMap(int *drv, int *sen)
+static unsigned int KeyMap(struct gsl_alg_ctx *ctx, int *drv, int *sen)
 {
 	struct KEY_TYPE_RANGE {
 		unsigned int up_down, left_right;
@@ -1384,7 +1941,7 @@ static unsigned int KeyMap(int *drv, int *sen)
 	return 0;
 }
 
-static unsigned int ScreenResolution(union gsl_POINT_TYPE *p)
+static unsigned int ScreenResolution(struct gsl_alg_ctx *ctx, union gsl_POINT_TYPE *p)
 {
 	int x, y;
 
@@ -1394,8 +1951,8 @@ static unsigned int ScreenResolution(union gsl_POINT_TYPE *p)
 		y = ((y - match_y[1]) * match_y[0] + 2048) / 4096;
 		x = ((x - match_x[1]) * match_x[0] + 2048) / 4096;
 	}
-	y = y * (int)screen_y_max / ((int)sen_num_nokey * 64);
-	x = x * (int)screen_x_max / ((int)drv_num_nokey * 64);
+	y = RecipDiv(&recip_res_y, y * (int)screen_y_max);
+	x = RecipDiv(&recip_res_x, x * (int)screen_x_max);
 	if (p->other.key == FALSE) {
 		if (id_flag.other.ignore_pri == 0) {
 			if (ignore_y[0] != 0 || ignore_y[1] != 0) {
@@ -1441,15 +1998,31 @@ static unsigned int ScreenResolution(union gsl_POINT_TYPE *p)
 			y = 0;
 		if (x < 0)
 			x = 0;
-		if ((key_map_able & 0x1) != FALSE && KeyMap(&x, &y) == 0)
+		if ((key_map_able & 0x1) != FALSE && KeyMap(ctx, &x, &y) == 0)
 			return 0;
 	}
 	return ((y << 16) & 0x0fff0000) + (x & 0x0000ffff);
 }
 
-static void PointReport(struct gsl_touch_info *cinfo)
+/* The point slot i reports, carried lookahead / 256 frames further along
+ * its last reported step by the same PointStep() that PointPredictSpeed()
+ * uses. Keys and first points stay where they are. */
+static union gsl_POINT_TYPE *PointAhead(struct gsl_alg_ctx *ctx, int i,
+					union gsl_POINT_TYPE *ahead)
+{
+	int r = point_delay[i].other.report;
+	union gsl_POINT_TYPE *p = &pr[r][i];
+
+	if (lookahead == 0 || r + 1 >= PR_DEEP || p->other.key ||
+	    pr[r + 1][i].all == 0)
+		return p;
+	ahead->all = PointStep(ctx, p, &pr[r + 1][i], lookahead, 256);
+	return ahead;
+}
+static void PointReport(struct gsl_alg_ctx *ctx, struct gsl_touch_info *cinfo)
 {
 	int i;
+	union gsl_POINT_TYPE ahead;
 	unsigned int data[POINT_MAX];
 	unsigned int dp[POINT_MAX];
 	int num = 0;
@@ -1477,8 +2050,8 @@ static void PointReport(struct gsl_touch_info *cinfo)
 			if (pr[point_delay[i].other.report][i].all) {
 				pr[point_delay[i].other.report][i].other.able =
 					1;
-				data[i] = ScreenResolution(
-					&pr[point_delay[i].other.report][i]);
+				data[i] = ScreenResolution(ctx,
+					PointAhead(ctx, i, &ahead));
 				if (data[i]) {
 					dp[i] = pressure_report[i];
 					data[i] |= (i + 1) << 28;
@@ -1498,8 +2071,8 @@ static void PointReport(struct gsl_touch_info *cinfo)
 			    0) {
 				pr[point_delay[i].other.report][i].other.able =
 					1;
-				data[i] = ScreenResolution(
-					&pr[point_delay[i].other.report][i]);
+				data[i] = ScreenResolution(ctx,
+					PointAhead(ctx, i, &ahead));
 				if (data[i]) {
 					dp[i] = pressure_report[i];
 					data[i] |= (i + 1) << 28;
@@ -1515,8 +2088,8 @@ static void PointReport(struct gsl_touch_info *cinfo)
 				continue;
 			if (point_delay[i].other.report >= PR_DEEP)
 				continue;
-			data[num] = ScreenResolution(
-				&pr[point_delay[i].other.report][i]);
+			data[num] = ScreenResolution(ctx,
+				PointAhead(ctx, i, &ahead));
 			if (data[num]) {
 				dp[num] = pressure_report[i];
 				data[num++] |= (i + 1) << 28;
@@ -1568,7 +2141,7 @@ static void PointReport(struct gsl_touch_info *cinfo)
 		prec_id.other.num = (unsigned char)point_num;
 }
 
-static void PointRound(void)
+static void PointRound(struct gsl_alg_ctx *ctx)
 {
 	int id, i;
 	int x, y;
@@ -1705,7 +2278,7 @@ static void PointRound(void)
 	}
 }
 
-static void PointEdge(void)
+static void PointEdge(struct gsl_alg_ctx *ctx)
 {
 	struct STRETCH_TYPE {
 		int range;
@@ -1851,9 +2424,8 @@ static void PointEdge(void)
 	}
 }
 
-static void PointStretch_for(int *dc_p, int *ds_p)
+static void PointStretch_for(struct gsl_alg_ctx *ctx, int *dc_p, int *ds_p)
 {
-	static int save_dr[POINT_MAX], save_dn[POINT_MAX];
 	int i, j;
 	int dn;
 	int dr;
@@ -1932,7 +2504,7 @@ static void PointStretch_for(int *dc_p, int *ds_p)
 				}
 			}
 		} else {
-			dn = PointDistance(&pp[0][i], &ps[1][i]);
+			dn = PointDistance(ctx, &pp[0][i], &ps[1][i]);
 			dn = Sqrt(dn);
 			if (dn >= ds[0])
 				continue;
@@ -1981,7 +2553,7 @@ static void PointStretch_for(int *dc_p, int *ds_p)
 	}
 }
 
-static void PointStretch(void)
+static void PointStretch(struct gsl_alg_ctx *ctx)
 {
 	struct SHAKE_TYPE {
 		int dis;
@@ -1994,17 +2566,22 @@ static void PointStretch(void)
 	int dc[9], ds[9];
 	int len = 8;
 	unsigned int temp;
+	unsigned int live = 0, m;
 
-	for (i = 0; i < POINT_MAX; i++)
+	/* ps[0] is still clear from PointPointer() */
+	for (m = point_mask; m; m &= m - 1) {
+		i = __builtin_ctz(m);
 		ps[0][i].all = pp[0][i].all;
+		if (pp[0][i].other.key == 0)
+			live |= 0x1 << i;
+	}
 
-	for (i = 0; i < POINT_MAX; i++) {
-		if (pp[0][i].all == 0 || pp[0][i].other.key) {
-			point_shake &= ~(0x1 << i);
-			if (i == 0)
-				point_edge.rate = 0;
-			continue;
-		}
+	/* empty and key slots only leave the shake state */
+	point_shake &= live;
+	if ((live & 0x1) == 0)
+		point_edge.rate = 0;
+	for (m = live; m; m &= m - 1) {
+		i = __builtin_ctz(m);
 		if (i == 0) {
 			if (edge_first != 0 && ps[1][i].all == 0) {
 				point_edge.coor.all = ps[0][i].all;
@@ -2029,14 +2606,14 @@ static void PointStretch(void)
 						sen_num_nokey * 64 -
 						((edge_first >> 0) & 0xff);
 				if (point_edge.coor.all != ps[0][i].all) {
-					point_edge.dis = PointDistance(
+					point_edge.dis = PointDistance(ctx,
 						&ps[0][i], &point_edge.coor);
 					if (point_edge.dis)
 						point_edge.rate = 0x1000;
 				}
 			}
 			if (point_edge.rate != 0 && point_edge.dis != 0) {
-				temp = PointDistance(&ps[0][i],
+				temp = PointDistance(ctx, &ps[0][i],
 						     &point_edge.coor);
 				if (temp >=
 				    point_edge.dis * edge_first_coe / 0x80) {
@@ -2074,8 +2651,8 @@ static void PointStretch(void)
 					break;
 			}
 			j--;
-			dn = PointDistance(&ps[0][i], &ps[j][i]);
-			if (PointDistance(&ps[0][i], &ps[j][i]) >=
+			dn = PointDistance(ctx, &ps[0][i], &ps[j][i]);
+			if (PointDistance(ctx, &ps[0][i], &ps[j][i]) >=
 			    (unsigned int)shake_min * 4) {
 				point_delay[i].other.init = 1;
 				point_delay[i].other.able = 1;
@@ -2083,7 +2660,7 @@ static void PointStretch(void)
 				point_delay[i].other.dele = 1;
 			}
 		} else if ((point_shake & (0x1 << i)) == 0) {
-			if (PointDistance(&ps[0][i], &ps[1][i]) <
+			if (PointDistance(ctx, &ps[0][i], &ps[1][i]) <
 			    (unsigned int)shake_min) {
 				if (point_delay[i].other.able)
 					ps[0][i].all = ps[1][i].all;
@@ -2115,7 +2692,7 @@ static void PointStretch(void)
 			}
 			if ((point_shake & (0x1 << i)) == 0)
 				continue;
-			dn = PointDistance(&pp[0][i], &ps[1][i]);
+			dn = PointDistance(ctx, &pp[0][i], &ps[1][i]);
 			dn = Sqrt(dn);
 			dr = dn > ds[0] ? dn - ds[0] : 0;
 			temp = ps[0][i].all;
@@ -2172,10 +2749,7 @@ static void PointStretch(void)
 		}
 
 	} else if (len >= 2) {
-		temp = 0;
-		for (i = 0; i < POINT_MAX; i++)
-			if (pp[0][i].all)
-				temp++;
+		temp = point_num;
 		if (temp > 5)
 			temp = 5;
 		for (i = 0; i < 8 && i < len; i++) {
@@ -2201,13 +2775,13 @@ static void PointStretch(void)
 					(shake_all[0].coe - shake_all[1].coe);
 			dc[0] = 128;
 		}
-		PointStretch_for(dc, ds);
+		PointStretch_for(ctx, dc, ds);
 	} else {
 		return;
 	}
 }
 
-static void ResetMask(void)
+static void ResetMask(struct gsl_alg_ctx *ctx)
 {
 	if (reset_mask_send)
 		reset_mask_send = 0;
@@ -2238,7 +2812,7 @@ static void ResetMask(void)
 	reset_mask_count++;
 	if (reset_mask_max == 0)
 		reset_mask_max = pp[0][0].all;
-	else if (PointDistance((union gsl_POINT_TYPE *)(&reset_mask_max),
+	else if (PointDistance(ctx, (union gsl_POINT_TYPE *)(&reset_mask_max),
 			       pp[0]) >
 			 (((unsigned int)reset_mask_dis) & 0xffffff) &&
 		 reset_mask_count > (((unsigned int)reset_mask_dis) >> 24))
@@ -2326,15 +2900,10 @@ static int ConfigKeyMap(unsigned int data[])
 	return TRUE;
 }
 
-static int DiagonalDistance(union gsl_POINT_TYPE *p, int type)
+static int DiagonalDistance(struct gsl_alg_ctx *ctx, union gsl_POINT_TYPE *p, int type)
 {
-	int divisor, square;
+	int square;
 
-	divisor = ((int)sen_num_nokey * (int)sen_num_nokey +
-		   (int)drv_num_nokey * (int)drv_num_nokey) /
-		  16;
-	if (divisor == 0)
-		divisor = 1;
 	if (type == 0)
 		square = ((int)sen_num_nokey * (int)(p->other.x) -
 			  (int)drv_num_nokey * (int)(p->other.y)) /
@@ -2344,10 +2913,10 @@ static int DiagonalDistance(union gsl_POINT_TYPE *p, int type)
 			  (int)drv_num_nokey * (int)(p->other.y) -
 			  (int)sen_num_nokey * (int)drv_num_nokey * 64) /
 			 4;
-	return square * square / divisor;
+	return RecipDiv(&recip_diagonal, square * square);
 }
 
-static void DiagonalCompress(union gsl_POINT_TYPE *p, int type, int dis,
+static void DiagonalCompress(struct gsl_alg_ctx *ctx, union gsl_POINT_TYPE *p, int type, int dis,
 			     int dis_max)
 {
 	int x, y;
@@ -2388,7 +2957,7 @@ static void DiagonalCompress(union gsl_POINT_TYPE *p, int type, int dis,
 	p->other.y = y;
 }
 
-static void PointDiagonal(void)
+static void PointDiagonal(struct gsl_alg_ctx *ctx)
 {
 	int i;
 	int diagonal_size;
@@ -2422,10 +2991,10 @@ static void PointDiagonal(void)
 				point_corner |= 0x1 << i * 2;
 		}
 		if (point_corner & (0x2 << i * 2)) {
-			dis = DiagonalDistance(&(ps[0][i]),
+			dis = DiagonalDistance(ctx, &(ps[0][i]),
 					       point_corner & (0x1 << i * 2));
 			if (dis <= diagonal_size * 4) {
-				DiagonalCompress(&(ps[0][i]),
+				DiagonalCompress(ctx, &(ps[0][i]),
 						 point_corner & (0x1 << i * 2),
 						 dis, diagonal_size);
 			} else if (dis > diagonal_size * 4) {
@@ -2436,7 +3005,7 @@ static void PointDiagonal(void)
 	}
 }
 
-static int PointSlope(int i, int j)
+static int PointSlope(struct gsl_alg_ctx *ctx, int i, int j)
 {
 	int x, y;
 
@@ -2452,7 +3021,7 @@ static int PointSlope(int i, int j)
 		return y * 1024 / (x + y);
 }
 
-static void PointExtend(void)
+static void PointExtend(struct gsl_alg_ctx *ctx)
 {
 	int i, j;
 	int x, y;
@@ -2470,11 +3039,11 @@ static void PointExtend(void)
 		}
 		if (j < extend_len)
 			continue;
-		if (PointDistance(&pr[1][i], &pr[2][i]) < 16 * 16)
+		if (PointDistance(ctx, &pr[1][i], &pr[2][i]) < 16 * 16)
 			continue;
-		t = PointSlope(i, 1);
+		t = PointSlope(ctx, i, 1);
 		for (j = 2; j < extend_len - 1; j++) {
-			t2 = PointSlope(i, j);
+			t2 = PointSlope(ctx, i, j);
 			if (t2 < 0 || t2 < t * (128 - point_extend) / 128 ||
 			    t2 > t * (128 + point_extend) / 128)
 				break;
@@ -2484,11 +3053,11 @@ static void PointExtend(void)
 		x = 3 * pr[1][i].other.x - 2 * pr[2][i].other.x;
 		y = 3 * pr[1][i].other.y - 2 * pr[2][i].other.y;
 		pr[0][i].all =
-			PointRange(x, y, pr[1][i].other.x, pr[1][i].other.y);
+			PointRange(ctx, x, y, pr[1][i].other.x, pr[1][i].other.y);
 	}
 }
 
-static void PressureSave(void)
+static void PressureSave(struct gsl_alg_ctx *ctx)
 {
 	int i;
 
@@ -2505,7 +3074,7 @@ static void PressureSave(void)
 	}
 }
 
-static void PointPressure(void)
+static void PointPressure(struct gsl_alg_ctx *ctx)
 {
 	int i, j;
 
@@ -2528,7 +3097,7 @@ static void PointPressure(void)
 	}
 }
 
-static void PressMask(void)
+static void PressMask(struct gsl_alg_ctx *ctx)
 {
 	int i, j;
 	unsigned int press_max = press_mask & 0xff;
@@ -2571,14 +3140,14 @@ static void PressMask(void)
 			if (pr[0][j].all == 0 || point_delay[j].other.able == 0)
 				continue;
 
-			if (PointDistance(&pp[0][i], &pp[0][j]) <
+			if (PointDistance(ctx, &pp[0][i], &pp[0][j]) <
 			    press_range * press_range)
 				point_delay[j].other.able = 0;
 		}
 	}
 }
 
-static void PressMove(void)
+static void PressMove(struct gsl_alg_ctx *ctx)
 {
 	int i;
 	/* POINT_TYPE_ID point_press_move; */
@@ -2596,7 +3165,7 @@ static void PressMove(void)
 	if (point_press_move.all == 0) {
 		point_press_move.all = pr[0][0].all;
 	} else if (point_press_move.other.x && point_press_move.other.y) {
-		if (PointDistance(&point_press_move, &pr[0][0]) >
+		if (PointDistance(ctx, &point_press_move, &pr[0][0]) >
 		    (press_move >> 16) * (press_move >> 16)) {
 			/* #define	x0		point_press_move.x */
 			/* #define	y0		point_press_move.y */
@@ -2654,7 +3223,7 @@ press_move_err:
 	point_press_move.all = 0;
 }
 
-int gsl_PressMove(void)
+int gsl_PressMove_ctx(struct gsl_alg_ctx *ctx)
 {
 	if (point_press_move.all <= 4)
 		return point_press_move.all;
@@ -2663,7 +3232,7 @@ int gsl_PressMove(void)
 }
 /* EXPORT_SYMBOL(gsl_PressMove); */
 
-void gsl_ReportPressure(unsigned int *p)
+void gsl_ReportPressure_ctx(struct gsl_alg_ctx *ctx, unsigned int *p)
 {
 	int i;
 
@@ -2689,7 +3258,7 @@ int gsl_TouchNear(void)
 }
 /* EXPORT_SYMBOL(gsl_TouchNear); */
 
-static void gsl_id_reg_init(int flag)
+static void gsl_id_reg_init(struct gsl_alg_ctx *ctx, int flag)
 {
 	int i, j;
 
@@ -2707,7 +3276,22 @@ static void gsl_id_reg_init(int flag)
 	for (i = 0; i < AVG_DEEP; i++)
 		avg[i] = 0;
 	point_edge.rate = 0;
-	point_n = 0;
+	for (i = 0; i < PP_DEEP * 2; i++) {
+		j = (PP_DEEP - i % PP_DEEP) % PP_DEEP;
+		point_ring[0][i] = point_array[j];
+		point_ring[1][i] = point_array[j + PP_DEEP];
+		point_ring[2][i] = point_array[j + PP_DEEP + PS_DEEP];
+	}
+	for (i = 0; i < PRESSURE_DEEP * 2; i++)
+		pressure_ring[i] =
+			pressure_array[(PRESSURE_DEEP - i % PRESSURE_DEEP) %
+				       PRESSURE_DEEP];
+	point_base = 0;
+	pressure_base = 0;
+	memcpy(pp, point_ring[0], sizeof(pp));
+	memcpy(ps, point_ring[1], sizeof(ps));
+	memcpy(pr, point_ring[2], sizeof(pr));
+	memcpy(pa, pressure_ring, sizeof(pa));
 	if (flag)
 		point_num = 0;
 	prev_num = 0;
@@ -2719,6 +3303,7 @@ static void gsl_id_reg_init(int flag)
 	point_corner = 0;
 	global_state.all = 0;
 	inte_count = 0;
+	idle_count = 0;
 	csensor_count = 0;
 	point_press_move.all = 0;
 	global_state.other.cc_128 = 0;
@@ -2732,7 +3317,7 @@ static void gsl_id_reg_init(int flag)
 	}
 }
 
-static int DataCheck(void)
+static int DataCheck(struct gsl_alg_ctx *ctx)
 {
 	if (drv_num == 0 || drv_num_nokey == 0 || sen_num == 0 ||
 	    sen_num_nokey == 0)
@@ -2742,14 +3327,14 @@ static int DataCheck(void)
 	return 1;
 }
 
-void gsl_DataInit(unsigned int *conf_in)
+void gsl_DataInit_ctx(struct gsl_alg_ctx *ctx, unsigned int *conf_in)
 {
 	ESP_LOGI(TAG,"gsl_DataInit");
 	int i, j;
 	unsigned int *conf;
 	int len;
 
-	gsl_id_reg_init(1);
+	gsl_id_reg_init(ctx, 1);
 	for (i = 0; i < POINT_MAX; i++)
 		point_now[i].all = 0;
 	conf = config_static;
@@ -3009,7 +3594,7 @@ void gsl_DataInit(unsigned int *conf_in)
 		}
 	}
 	/* --------------------------------------------- */
-	gsl_id_reg_init(0);
+	gsl_id_reg_init(ctx, 0);
 	/* --------------------------------------------- */
 	if (average == 0)
 		average = 4;
@@ -3030,6 +3615,14 @@ void gsl_DataInit(unsigned int *conf_in)
 		if (ignore_y[i] & 0x8000)
 			ignore_y[i] |= 0xffff0000;
 	}
+	DistanceScaleInit(ctx);
+	CoordinateCorrectInit(ctx);
+	FilterInit(ctx);
+	RecipInit(&recip_res_x, (int)drv_num_nokey * 64);
+	RecipInit(&recip_res_y, (int)sen_num_nokey * 64);
+	j = ((int)sen_num_nokey * (int)sen_num_nokey +
+	     (int)drv_num_nokey * (int)drv_num_nokey) / 16;
+	RecipInit(&recip_diagonal, j ? j : 1);
 	for (i = 0; i < CONFIG_LENGTH; i++)
 		config_static[i] = 0;
 }
@@ -3041,13 +3634,13 @@ unsigned int gsl_version_id(void)
 }
 
 
-unsigned int gsl_mask_tiaoping(void)
+unsigned int gsl_mask_tiaoping_ctx(struct gsl_alg_ctx *ctx)
 {
 	// printf("reset_mask_send:%d\r\n",reset_mask_send);
 	return reset_mask_send;
 }
 
-static void GetFlag(void)
+static void GetFlag(struct gsl_alg_ctx *ctx)
 {
 	int i = 0;
 	int num_save;
@@ -3062,7 +3655,7 @@ static void GetFlag(void)
 	}
 	if (((point_num & 0x100) != 0) ||
 	    ((point_num & 0x200) != 0 && global_state.other.reset == 1)) {
-		gsl_id_reg_init(0);
+		gsl_id_reg_init(ctx, 0);
 	}
 	if ((point_num & 0x300) == 0)
 		global_state.other.reset = 1;
@@ -3089,13 +3682,13 @@ static void GetFlag(void)
 		    global_state.other.active_prev) {
 			if (global_state.other.active) {
 				if (prec_id.other.num)
-					gsl_id_reg_init(1);
+					gsl_id_reg_init(ctx, 1);
 				else
-					gsl_id_reg_init(0);
+					gsl_id_reg_init(ctx, 0);
 				global_state.other.active = 1;
 				global_state.other.active_prev = 1;
 			} else
-				gsl_id_reg_init(0);
+				gsl_id_reg_init(ctx, 0);
 		}
 	}
 	inte_count++;
@@ -3110,7 +3703,7 @@ static void GetFlag(void)
 	point_num = (point_num & (~0xff)) + num_save;
 }
 
-static void PointIgnore(void)
+static void PointIgnore(struct gsl_alg_ctx *ctx)
 {
 	int i, x, y;
 
@@ -3119,10 +3712,10 @@ static void PointIgnore(void)
 	for (i = 0; i < point_num; i++) {
 		if (point_now[i].other.key)
 			continue;
-		y = point_now[i].other.y * (int)screen_y_max /
-		    ((int)sen_num_nokey * 64);
-		x = point_now[i].other.x * (int)screen_x_max /
-		    ((int)drv_num_nokey * 64);
+		y = RecipDiv(&recip_res_y,
+			     point_now[i].other.y * (int)screen_y_max);
+		x = RecipDiv(&recip_res_x,
+			     point_now[i].other.x * (int)screen_x_max);
 		if ((ignore_y[0] != 0 || ignore_y[1] != 0)) {
 			if (y < ignore_y[0])
 				point_now[i].all = 0;
@@ -3151,50 +3744,195 @@ static void PointIgnore(void)
 	point_num = x;
 }
 
-void gsl_alg_id_main(struct gsl_touch_info *cinfo)
+void gsl_alg_set_lookahead_ctx(struct gsl_alg_ctx *ctx, unsigned int frames)
+{
+	lookahead = frames < LOOKAHEAD_MAX ? frames : LOOKAHEAD_MAX;
+}
+
+void gsl_alg_set_adaptive_delay_ctx(struct gsl_alg_ctx *ctx, int on)
+{
+	adaptive_delay = on != 0;
+}
+
+void gsl_alg_get_delay_stat_ctx(struct gsl_alg_ctx *ctx,
+				struct gsl_delay_stat *stat)
+{
+	*stat = delay_stat;
+}
+
+int gsl_alg_is_idle_ctx(struct gsl_alg_ctx *ctx)
+{
+	return idle_count >= IDLE_FRAMES && reset_mask_send == 0 &&
+	       reset_mask_max <= 0xf0000000;
+}
+
+#ifdef GSL_STAGE_PROFILE
+static void StageRecord(struct gsl_alg_ctx *ctx, int stage, unsigned int ticks)
+{
+	unsigned int n = ctx->stage_count[stage]++;
+
+	ctx->stage_ticks[stage][n % GSL_STAGE_PROFILE_SAMPLES] = ticks;
+}
+
+#define STAGE(name, call)                                                      \
+	do {                                                                   \
+		unsigned int stage_t0 = gsl_stage_clock();                     \
+		call;                                                          \
+		StageRecord(ctx, GSL_STAGE_##name,                             \
+			    gsl_stage_clock() - stage_t0);                     \
+	} while (0)
+
+int gsl_stage_profile_ctx(struct gsl_alg_ctx *ctx, struct gsl_stage_stat *stat,
+			  int max)
+{
+	int t[GSL_STAGE_PROFILE_SAMPLES];
+	int i, n;
+
+	for (i = 0; i < GSL_STAGE_COUNT && i < max; i++) {
+		n = ctx->stage_count[i] < GSL_STAGE_PROFILE_SAMPLES ?
+			    ctx->stage_count[i] : GSL_STAGE_PROFILE_SAMPLES;
+		memcpy(t, ctx->stage_ticks[i], n * sizeof(t[0]));
+		SortBubble(t, n);
+		stat[i].name = gsl_stage_names[i];
+		stat[i].calls = ctx->stage_count[i];
+		stat[i].median = n ? t[n / 2] : 0;
+		stat[i].p99 = n ? t[(n * 99 + 99) / 100 - 1] : 0;
+	}
+	return GSL_STAGE_COUNT;
+}
+
+void gsl_stage_profile_reset_ctx(struct gsl_alg_ctx *ctx)
+{
+	memset(ctx->stage_count, 0, sizeof(ctx->stage_count));
+}
+#else
+#define STAGE(name, call) call
+#endif
+
+void gsl_alg_id_main_ctx(struct gsl_alg_ctx *ctx, struct gsl_touch_info *cinfo)
 {
 	int i;
+	int input = cinfo->finger_num;
+	int valid;
+#ifdef GSL_STAGE_PROFILE
+	unsigned int frame_t0 = gsl_stage_clock();
+#endif
 	// ESP_LOGI(TAG,"gsl_alg_id_main");
 	point_num = cinfo->finger_num;
 	for (i = 0; i < POINT_MAX; i++)
 		point_now[i].all = (cinfo->id[i] << 28) | (cinfo->x[i] << 16) |
 				   cinfo->y[i];
 
-	GetFlag();
-	if (DataCheck() == 0) {
+	STAGE(GetFlag, GetFlag(ctx));
+	STAGE(DataCheck, valid = DataCheck(ctx));
+	if (valid == 0) {
 		point_num = 0;
 		cinfo->finger_num = 0;
+		idle_count = 0;
+#ifdef GSL_STAGE_PROFILE
+		StageRecord(ctx, GSL_STAGE_ALL, gsl_stage_clock() - frame_t0);
+#endif
 		return;
 	}
-	PressureSave();
+	STAGE(PressureSave, PressureSave(ctx));
 	point_num &= 0xff;
-	PointIgnore();
-	PointCoor();
-	CoordinateCorrect();
-	PointEdge();
-	PointRound();
-	PointRepeat();
-	GetPointNum(point_now);
-	PointPointer();
-	PointPredict();
-	PointId();
-	PointNewId();
-	PointOrder();
-	PointCross();
-	GetPointNum(pp[0]);
+	if (point_num == 0 && gsl_alg_is_idle_ctx(ctx)) {
+		/* Settled: every ring row is empty and the delay, pressure and
+		 * reset mask state already is what an empty frame leaves, so
+		 * the rest of the pipeline would only step the rings */
+		STAGE(PointPointer, PointPointer(ctx));
+		cinfo->finger_num = 0;
+		if (input != 0)
+			idle_count = 0;
+#ifdef GSL_STAGE_PROFILE
+		StageRecord(ctx, GSL_STAGE_ALL, gsl_stage_clock() - frame_t0);
+#endif
+		return;
+	}
+	STAGE(PointIgnore, PointIgnore(ctx));
+	STAGE(PointCoor, PointCoor(ctx));
+	STAGE(CoordinateCorrect, CoordinateCorrect(ctx));
+	STAGE(PointEdge, PointEdge(ctx));
+	STAGE(PointRound, PointRound(ctx));
+	STAGE(PointRepeat, PointRepeat(ctx));
+	STAGE(GetPointNum_now, GetPointNum(ctx, point_now));
+	STAGE(PointPointer, PointPointer(ctx));
+	STAGE(PointPredict, PointPredict(ctx));
+	STAGE(PointId, PointId(ctx));
+	STAGE(PointNewId, PointNewId(ctx));
+	STAGE(PointOrder, PointOrder(ctx));
+	STAGE(GetPointNum_pp, GetPointNum(ctx, pp[0]));
+	STAGE(PointCross, PointCross(ctx));
 
 	prev_num = point_num;
-	ResetMask();
-	PointStretch();
-	PointDiagonal();
-	PointFilter();
-	GetPointNum(pr[0]);
-
-	PointDelay();
-	PointMenu();
-	PointExtend();
-	PointPressure();
-	PressMove();
-	PressMask();
-	PointReport(cinfo);
+	STAGE(ResetMask, ResetMask(ctx));
+	STAGE(PointStretch, PointStretch(ctx));
+	STAGE(PointDiagonal, PointDiagonal(ctx));
+	STAGE(PointFilter, PointFilter(ctx));
+	STAGE(GetPointNum_pr, GetPointNum(ctx, pr[0]));
+
+	STAGE(PointDelay, PointDelay(ctx));
+	STAGE(PointMenu, PointMenu(ctx));
+	STAGE(PointExtend, PointExtend(ctx));
+	STAGE(PointPressure, PointPressure(ctx));
+	STAGE(PressMove, PressMove(ctx));
+	STAGE(PressMask, PressMask(ctx));
+	STAGE(PointReport, PointReport(ctx, cinfo));
+
+	if (input == 0 && cinfo->finger_num == 0) {
+		if (idle_count < IDLE_FRAMES)
+			idle_count++;
+	} else
+		idle_count = 0;
+#ifdef GSL_STAGE_PROFILE
+	StageRecord(ctx, GSL_STAGE_ALL, gsl_stage_clock() - frame_t0);
+#endif
+}
+
+size_t gsl_alg_ctx_size(void)
+{
+	return sizeof(struct gsl_alg_ctx);
+}
+
+/* Single-controller API, runs on a built-in context */
+static struct gsl_alg_ctx gsl_default_ctx;
+
+int gsl_PressMove(void)
+{
+	return gsl_PressMove_ctx(&gsl_default_ctx);
+}
+
+void gsl_ReportPressure(unsigned int *p)
+{
+	gsl_ReportPressure_ctx(&gsl_default_ctx, p);
+}
+
+void gsl_DataInit(unsigned int *conf_in)
+{
+	gsl_DataInit_ctx(&gsl_default_ctx, conf_in);
+}
+
+unsigned int gsl_mask_tiaoping(void)
+{
+	return gsl_mask_tiaoping_ctx(&gsl_default_ctx);
+}
+
+void gsl_alg_set_lookahead(unsigned int frames)
+{
+	gsl_alg_set_lookahead_ctx(&gsl_default_ctx, frames);
+}
+
+void gsl_alg_set_adaptive_delay(int on)
+{
+	gsl_alg_set_adaptive_delay_ctx(&gsl_default_ctx, on);
+}
+
+int gsl_alg_is_idle(void)
+{
+	return gsl_alg_is_idle_ctx(&gsl_default_ctx);
+}
+
+void gsl_alg_id_main(struct gsl_touch_info *cinfo)
+{
+	gsl_alg_id_main_ctx(&gsl_default_ctx, cinfo);
 }
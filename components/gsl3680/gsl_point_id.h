@@ -1,6 +1,8 @@
 #ifndef _GSL_POINT_ID_H
 #define _GSL_POINT_ID_H
 
+#include <stddef.h>
+
 struct gsl_touch_info
 {
     int x[10];
@@ -12,6 +14,78 @@ struct gsl_touch_info
 unsigned int gsl_mask_tiaoping(void);
 unsigned int gsl_version_id(void);
 void gsl_alg_id_main(struct gsl_touch_info *cinfo);
+/* Nonzero once enough empty frames have passed to flush the point history and pending reports,
+ * gsl_alg_id_main() then steps an empty frame through without running the pipeline */
+int gsl_alg_is_idle(void);
+/* Report each finger frames / 256 frames ahead along its last step, 0 = off, capped at 4 frames */
+void gsl_alg_set_lookahead(unsigned int frames);
+/* Nonzero releases a new finger before its configured report delay once it
+ * has settled: seen twice and moving no faster than the noise of reported fingers */
+void gsl_alg_set_adaptive_delay(int on);
 void gsl_DataInit(unsigned int *conf_in);
 
+/* Fill cinfo from the coordinate registers at 0x80: a 4 byte header with the
+ * finger count in the low byte and algorithm flags above it, then 4 bytes per
+ * finger (y lo, y hi, x lo, x hi | id << 4). count is the number of fingers
+ * present in buf, it replaces the count of the header. */
+static inline void gsl_touch_info_from_frame(struct gsl_touch_info *cinfo, const unsigned char *buf, int count)
+{
+    int i;
+
+    for (i = 0; i < count && i < 10; i++) {
+        const unsigned char *p = &buf[4 + 4 * i];
+        cinfo->x[i] = ((p[3] & 0x0f) << 8) | p[2];
+        cinfo->y[i] = (p[1] << 8) | p[0];
+        cinfo->id[i] = (p[3] & 0xf0) >> 4;
+    }
+    for (; i < 10; i++) {
+        cinfo->x[i] = cinfo->y[i] = cinfo->id[i] = 0;
+    }
+    cinfo->finger_num = (buf[3] << 24) | (buf[2] << 16) | (buf[1] << 8) | (count & 0xff);
+}
+
+/* The functions above share one built-in algorithm state. For several
+ * controllers, or to run the algorithm on several cores, give each one its
+ * own context: gsl_alg_ctx_size() zeroed bytes, then gsl_DataInit_ctx(). */
+struct gsl_alg_ctx;
+
+size_t gsl_alg_ctx_size(void);
+unsigned int gsl_mask_tiaoping_ctx(struct gsl_alg_ctx *ctx);
+void gsl_alg_id_main_ctx(struct gsl_alg_ctx *ctx, struct gsl_touch_info *cinfo);
+int gsl_alg_is_idle_ctx(struct gsl_alg_ctx *ctx);
+void gsl_alg_set_lookahead_ctx(struct gsl_alg_ctx *ctx, unsigned int frames);
+void gsl_alg_set_adaptive_delay_ctx(struct gsl_alg_ctx *ctx, int on);
+void gsl_DataInit_ctx(struct gsl_alg_ctx *ctx, unsigned int *conf_in);
+int gsl_PressMove_ctx(struct gsl_alg_ctx *ctx);
+void gsl_ReportPressure_ctx(struct gsl_alg_ctx *ctx, unsigned int *p);
+
+/* Decisions of the report delay on new fingers, counted while the config
+ * holds fingers back. held counts frames, the others fingers. */
+struct gsl_delay_stat {
+    unsigned int held;      /* frames a new finger was held back */
+    unsigned int early;     /* released settled by the adaptive delay */
+    unsigned int released;  /* released after the full configured delay */
+    unsigned int dropped;   /* lifted before they were released */
+    unsigned int unsteady;  /* held frames across a change of the scan interval, adaptive delay only */
+    unsigned int noise;     /* step noise of reported fingers in 1/16 units, adaptive delay only */
+};
+
+void gsl_alg_get_delay_stat_ctx(struct gsl_alg_ctx *ctx, struct gsl_delay_stat *stat);
+
+#ifdef GSL_STAGE_PROFILE
+/* Built with -DGSL_STAGE_PROFILE, gsl_alg_id_main_ctx() times each of its
+ * stages: CPU cycles on the ESP target, TSC or nanoseconds on a host. The
+ * figures cover the last GSL_STAGE_PROFILE_SAMPLES calls of every stage. */
+struct gsl_stage_stat {
+    const char *name;       /* stage function, "total" for the whole frame */
+    unsigned int calls;
+    unsigned int median;
+    unsigned int p99;
+};
+
+/* Fill up to max entries in call order, returns the number of stages */
+int gsl_stage_profile_ctx(struct gsl_alg_ctx *ctx, struct gsl_stage_stat *stat, int max);
+void gsl_stage_profile_reset_ctx(struct gsl_alg_ctx *ctx);
+#endif
+
 #endif
@@ -1,15 +1,40 @@
 from esphome import pins
 import esphome.codegen as cg
-from esphome.components import i2c, touchscreen
+from esphome.core import TimePeriod
+from esphome.components import i2c, sensor, touchscreen
 import esphome.config_validation as cv
+import esphome.final_validate as fv
 from esphome.const import (
     CONF_ID, 
     CONF_INTERRUPT_PIN, 
+    CONF_PLATFORM,
     CONF_RESET_PIN,
+    CONF_RAW_DATA_ID,
+    ENTITY_CATEGORY_DIAGNOSTIC,
+    STATE_CLASS_MEASUREMENT,
+    UNIT_MILLISECOND,
 )
 
+from .firmware import firmware_signature, pack_firmware, parse_firmware
+
+AUTO_LOAD = ["sensor"]
+
 ns_ = cg.esphome_ns.namespace("gsl3680")
 
+CONF_FIRMWARE_BURST_SIZE = "firmware_burst_size"
+CONF_PACKED_FIRMWARE = "packed_firmware"
+CONF_WARM_START = "warm_start"
+CONF_MAX_TOUCH_POINTS = "max_touch_points"
+CONF_LOOKAHEAD = "lookahead"
+CONF_ADAPTIVE_DELAY = "adaptive_delay"
+CONF_FIRMWARE_TIME_SAVED = "firmware_time_saved"
+CONF_BUS_BYTES_SAVED = "bus_bytes_saved"
+CONF_ACQUISITION_TASK = "acquisition_task"
+CONF_CORE = "core"
+CONF_PRIORITY = "priority"
+
+UNIT_BYTES_PER_SECOND = "B/s"
+
 cls_ = ns_.class_(
     "GSL3680",
     touchscreen.Touchscreen,
@@ -23,12 +48,102 @@ CONFIG_SCHEMA = (
             cv.GenerateID(): cv.declare_id(cls_),
             cv.Required(CONF_INTERRUPT_PIN): pins.internal_gpio_input_pin_schema,
             cv.Required(CONF_RESET_PIN): pins.internal_gpio_input_pin_schema,
+            cv.Optional(CONF_FIRMWARE_BURST_SIZE, default=8): cv.int_range(min=1, max=32),
+            cv.Optional(CONF_PACKED_FIRMWARE, default=True): cv.boolean,
+            cv.Optional(CONF_WARM_START, default=True): cv.boolean,
+            cv.Optional(CONF_MAX_TOUCH_POINTS, default=10): cv.int_range(min=1, max=10),
+            cv.Optional(CONF_LOOKAHEAD, default="0ms"): cv.All(
+                cv.positive_time_period_milliseconds,
+                cv.Range(max=TimePeriod(milliseconds=100)),
+            ),
+            cv.Optional(CONF_ADAPTIVE_DELAY, default=False): cv.boolean,
+            cv.Optional(CONF_ACQUISITION_TASK): cv.Schema(
+                {
+                    cv.Optional(CONF_CORE, default=1): cv.int_range(min=0, max=1),
+                    cv.Optional(CONF_PRIORITY, default=5): cv.int_range(min=1, max=24),
+                }
+            ),
+            cv.GenerateID(CONF_RAW_DATA_ID): cv.declare_id(cg.uint8),
+            cv.Optional(CONF_FIRMWARE_TIME_SAVED): sensor.sensor_schema(
+                unit_of_measurement=UNIT_MILLISECOND,
+                accuracy_decimals=0,
+                state_class=STATE_CLASS_MEASUREMENT,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            ),
+            cv.Optional(CONF_BUS_BYTES_SAVED): sensor.sensor_schema(
+                unit_of_measurement=UNIT_BYTES_PER_SECOND,
+                accuracy_decimals=0,
+                state_class=STATE_CLASS_MEASUREMENT,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            ),
         }
     )
     .extend(i2c.i2c_device_schema(0x40))
 )
 
 
+def _config_id(value):
+    return getattr(value, "id", value)
+
+
+def _find_i2c_users(node, bus, found):
+    if isinstance(node, dict):
+        if _config_id(node.get(i2c.CONF_I2C_ID)) == bus:
+            found.append(node)
+        for value in node.values():
+            _find_i2c_users(value, bus, found)
+    elif isinstance(node, list):
+        for value in node:
+            _find_i2c_users(value, bus, found)
+
+
+def _validate_acquisition_task(config):
+    """The acquisition task reads the controller outside the main loop.
+
+    ESPHome's I2C bus object is not safe to use from two tasks at once, so a
+    task-driven GSL3680 must be the only device on its bus.
+    """
+    if CONF_ACQUISITION_TASK not in config:
+        return
+    bus = _config_id(config[i2c.CONF_I2C_ID])
+    found = []
+    _find_i2c_users(fv.full_config.get(), bus, found)
+    own = _config_id(config[CONF_ID])
+    others = [str(_config_id(conf.get(CONF_ID))) for conf in found if _config_id(conf.get(CONF_ID)) != own]
+    if others:
+        raise cv.Invalid(
+            f"{CONF_ACQUISITION_TASK} needs I2C bus '{bus}' to itself, it is also used by {', '.join(others)}"
+        )
+
+
+def _validate_packed_firmware(config):
+    """The packed image compiles GSLX680_FW out of the whole build.
+
+    ESP_LCD_TOUCH_GSL3680_PACKED_FW is a build flag, not a per-instance
+    setting, so every GSL3680 has to agree on packed_firmware.
+    """
+    screens = fv.full_config.get().get("touchscreen", [])
+    others = [
+        str(_config_id(conf.get(CONF_ID)))
+        for conf in screens
+        if conf.get(CONF_PLATFORM) == "gsl3680"
+        and conf.get(CONF_PACKED_FIRMWARE, True) != config[CONF_PACKED_FIRMWARE]
+    ]
+    if others:
+        raise cv.Invalid(
+            f"{CONF_PACKED_FIRMWARE} must be the same for every gsl3680, {', '.join(others)} set it differently"
+        )
+
+
+def _final_validate(config):
+    _validate_acquisition_task(config)
+    _validate_packed_firmware(config)
+    return config
+
+
+FINAL_VALIDATE_SCHEMA = _final_validate
+
+
 async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID])
     await touchscreen.register_touchscreen(var, config)
@@ -36,4 +151,26 @@ async def to_code(config):
 
     cg.add(var.set_interrupt_pin(await cg.gpio_pin_expression(config.get(CONF_INTERRUPT_PIN))))
     cg.add(var.set_reset_pin(await cg.gpio_pin_expression(config.get(CONF_RESET_PIN))))
+    cg.add(var.set_firmware_burst_size(config[CONF_FIRMWARE_BURST_SIZE]))
+    cg.add(var.set_max_touch_points(config[CONF_MAX_TOUCH_POINTS]))
+    cg.add(var.set_lookahead(config[CONF_LOOKAHEAD].total_milliseconds))
+    cg.add(var.set_adaptive_delay(config[CONF_ADAPTIVE_DELAY]))
+    if task := config.get(CONF_ACQUISITION_TASK):
+        cg.add(var.set_acquisition_task(task[CONF_CORE], task[CONF_PRIORITY]))
+
+    firmware = parse_firmware()
+    if config[CONF_WARM_START]:
+        cg.add(var.set_firmware_signature(*firmware_signature(firmware)))
+    if CONF_FIRMWARE_TIME_SAVED in config:
+        sens = await sensor.new_sensor(config[CONF_FIRMWARE_TIME_SAVED])
+        cg.add(var.set_firmware_time_saved_sensor(sens))
+    if CONF_BUS_BYTES_SAVED in config:
+        sens = await sensor.new_sensor(config[CONF_BUS_BYTES_SAVED])
+        cg.add(var.set_bus_bytes_saved_sensor(sens))
+
+    if config[CONF_PACKED_FIRMWARE]:
+        blob = pack_firmware(firmware)
+        prog_arr = cg.progmem_array(config[CONF_RAW_DATA_ID], list(blob))
+        cg.add(var.set_firmware_data(prog_arr, len(blob)))
+        cg.add_build_flag("-DESP_LCD_TOUCH_GSL3680_PACKED_FW")
 
@@ -0,0 +1,159 @@
+#include <string.h>
+#include "mock_gsl3680.h"
+#include "esp_timer.h"
+#include "driver/gpio.h"
+#include "freertos/task.h"
+#include "esp_lcd_touch.h"
+#include "esp_lcd_gsl3680.h"
+
+struct mock_gsl3680 mock;
+
+void mock_power_on(void)
+{
+    int64_t now_us = mock.now_us;
+
+    memset(&mock, 0, sizeof(mock));
+    mock.now_us = now_us;
+    mock.boots = true;
+    mock.xfer_us = 50;
+    mock.byte_us = 23;
+}
+
+void mock_clear_counters(void)
+{
+    mock.writes = 0;
+    mock.reads = 0;
+    mock.fw_writes = 0;
+    mock.fw_bytes = 0;
+    mock.max_fw_write = 0;
+    mock.fw_write_out_of_page = false;
+}
+
+void mock_table_image(uint8_t image[MOCK_PAGES][MOCK_PAGE_SIZE])
+{
+    int page = 0;
+
+    memset(image, 0, MOCK_PAGES * MOCK_PAGE_SIZE);
+    for (size_t i = 0; i < sizeof(GSLX680_FW) / sizeof(GSLX680_FW[0]); i++) {
+        uint8_t reg = (uint8_t)GSLX680_FW[i].offset;
+        uint32_t val = GSLX680_FW[i].val;
+
+        if (reg == 0xf0) {
+            page = val & 0xff;
+            continue;
+        }
+        for (int k = 0; k < 4; k++) {
+            image[page][reg + k] = (uint8_t)(val >> (8 * k));
+        }
+    }
+}
+
+int mock_fw_differs(uint8_t image[MOCK_PAGES][MOCK_PAGE_SIZE])
+{
+    for (int page = 0; page < MOCK_PAGES; page++) {
+        if (memcmp(mock.ram[page], image[page], MOCK_FW_REGS) != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+esp_lcd_panel_io_handle_t mock_io(void)
+{
+    return (esp_lcd_panel_io_handle_t)&mock;
+}
+
+esp_err_t esp_lcd_panel_io_tx_param(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void *param, size_t param_size)
+{
+    const uint8_t *data = param;
+
+    (void)io;
+    mock.writes++;
+    mock.now_us += mock.xfer_us + mock.byte_us * param_size;
+    if (lcd_cmd == 0xf0) {
+        mock.page = data[0];
+        return ESP_OK;
+    }
+    if (lcd_cmd == 0xe0) {
+        /* 0x88 halts the core, 0x00 releases it */
+        mock.running = data[0] == 0x00;
+        return ESP_OK;
+    }
+    if (lcd_cmd < MOCK_FW_REGS) {
+        mock.fw_writes++;
+        mock.fw_bytes += param_size;
+        if (param_size > mock.max_fw_write) {
+            mock.max_fw_write = param_size;
+        }
+        if (lcd_cmd + param_size > MOCK_FW_REGS) {
+            mock.fw_write_out_of_page = true;
+        }
+    }
+    if (lcd_cmd + param_size > MOCK_PAGE_SIZE) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(&mock.ram[mock.page][lcd_cmd], data, param_size);
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_io_rx_param(esp_lcd_panel_io_handle_t io, int lcd_cmd, void *param, size_t param_size)
+{
+    (void)io;
+    mock.reads++;
+    mock.now_us += mock.xfer_us + mock.byte_us * param_size;
+    if (lcd_cmd == 0xb0) {
+        memset(param, mock.running && mock.boots ? 0x5a : 0x00, param_size);
+        return ESP_OK;
+    }
+    if (lcd_cmd + param_size > MOCK_PAGE_SIZE) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(param, &mock.ram[mock.page][lcd_cmd], param_size);
+    return ESP_OK;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return mock.now_us;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    mock.now_us += (int64_t)ticks * 1000;
+}
+
+esp_err_t gpio_config(const gpio_config_t *config)
+{
+    (void)config;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+    /* the tests wire reset to GPIO 1 and the interrupt line to GPIO 2 */
+    if (gpio_num == 1) {
+        mock.rst_level = level;
+    } else if (gpio_num == 2) {
+        mock.int_level = level;
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t gpio_num)
+{
+    (void)gpio_num;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num)
+{
+    (void)gpio_num;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_touch_register_interrupt_callback(esp_lcd_touch_handle_t tp, esp_lcd_touch_interrupt_callback_t callback)
+{
+    (void)tp;
+    (void)callback;
+    return ESP_OK;
+}
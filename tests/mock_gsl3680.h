@@ -0,0 +1,47 @@
+/*
+ * A GSL3680 for the driver tests: paged registers behind the panel IO, the
+ * core run state, the reset and interrupt pins and a clock that advances with
+ * every bus transfer and task delay.
+ */
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_lcd_panel_io.h"
+
+#define MOCK_PAGES          256
+#define MOCK_PAGE_SIZE      256
+/* firmware lives below the coordinate registers of every page */
+#define MOCK_FW_REGS        0x80
+
+struct mock_gsl3680 {
+    uint8_t ram[MOCK_PAGES][MOCK_PAGE_SIZE];
+    int page;               /* selected through 0xf0 */
+    bool running;           /* core released through 0xe0 */
+    bool boots;             /* a released core reports 0x5a5a5a5a in 0xb0 */
+    int rst_level;
+    int int_level;
+
+    int64_t now_us;
+    uint32_t xfer_us;       /* bus time of a transfer without data: address and register */
+    uint32_t byte_us;       /* bus time of each data byte */
+
+    unsigned writes;        /* every register write */
+    unsigned reads;
+    unsigned fw_writes;     /* writes into the firmware registers */
+    unsigned fw_bytes;
+    size_t max_fw_write;    /* longest firmware write in bytes */
+    bool fw_write_out_of_page; /* a firmware write ran past MOCK_FW_REGS */
+};
+
+extern struct mock_gsl3680 mock;
+
+/* power cycle: RAM cleared, core halted, 400 kHz bus timing */
+void mock_power_on(void);
+/* clear the transfer counters, keep RAM and time */
+void mock_clear_counters(void);
+/* what GSLX680_FW leaves in RAM when it is written one word at a time */
+void mock_table_image(uint8_t image[MOCK_PAGES][MOCK_PAGE_SIZE]);
+/* nonzero if the firmware registers of every page match image */
+int mock_fw_differs(uint8_t image[MOCK_PAGES][MOCK_PAGE_SIZE]);
+/* a handle the driver can store, the mock has only one bus */
+esp_lcd_panel_io_handle_t mock_io(void);
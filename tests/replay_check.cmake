@@ -0,0 +1,12 @@
+# cmake -DREPLAY=... -DTRACE=... -DEXPECTED=... -DOUTPUT=... [-DARGS=...] -P replay_check.cmake
+execute_process(COMMAND ${REPLAY} ${ARGS} ${TRACE}
+    OUTPUT_FILE ${OUTPUT}
+    RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "gsl_replay failed: ${result}")
+endif()
+execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${OUTPUT} ${EXPECTED}
+    RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${OUTPUT} differs from ${EXPECTED}")
+endif()
@@ -0,0 +1,2 @@
+/* Host stand-in for the ESP-IDF header of the same name, the driver reaches the bus through the panel IO */
+#pragma once
@@ -0,0 +1,10 @@
+/* Host stand-in for the ESP-IDF header of the same name, the tests implement the transfers */
+#pragma once
+#include <stddef.h>
+#include "esp_err.h"
+
+typedef struct esp_lcd_panel_io_t esp_lcd_panel_io_t;
+typedef esp_lcd_panel_io_t *esp_lcd_panel_io_handle_t;
+
+esp_err_t esp_lcd_panel_io_rx_param(esp_lcd_panel_io_handle_t io, int lcd_cmd, void *param, size_t param_size);
+esp_err_t esp_lcd_panel_io_tx_param(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void *param, size_t param_size);
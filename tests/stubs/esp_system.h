@@ -0,0 +1,17 @@
+/* Host stand-in for the ESP-IDF header of the same name, only what the driver tests use */
+#pragma once
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MALLOC_CAP_DEFAULT      0
+#define BIT64(nr)               (1ULL << (nr))
+#define __containerof(ptr, type, member) ((type *)((char *)(ptr) - offsetof(type, member)))
+
+static inline void *heap_caps_calloc(size_t n, size_t size, int caps)
+{
+    (void)caps;
+    return calloc(n, size);
+}
@@ -0,0 +1,22 @@
+/* Host stand-in for the FreeRTOS header of the same name, single threaded */
+#pragma once
+#include <stdint.h>
+#include "esp_system.h"
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+
+typedef struct {
+    uint32_t owner;
+    uint32_t count;
+} portMUX_TYPE;
+
+#define portMUX_FREE_VAL        0xB33FFFFF
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux)  ((void)(mux))
+
+/* 1 kHz tick, as in the ESPHome builds */
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(ms))
+#define pdTRUE                  1
+#define pdFALSE                 0
+#define pdPASS                  pdTRUE
@@ -0,0 +1,2 @@
+/* Host stand-in for the FreeRTOS header of the same name, nothing the driver uses */
+#pragma once
@@ -0,0 +1,5 @@
+/* Host stand-in for the FreeRTOS header of the same name, the tests implement the delay */
+#pragma once
+#include "FreeRTOS.h"
+
+void vTaskDelay(TickType_t ticks);
@@ -0,0 +1,2 @@
+/* Host stand-in for the generated ESP-IDF config, esp_lcd_touch.h sets its own defaults */
+#pragma once
@@ -0,0 +1,257 @@
+/*
+ * esp_lcd_touch_gsl3680_bringup_poll() driven the way GSL3680::loop() drives
+ * it, against the mock controller and its clock: it must never block for
+ * longer than one upload slice, never touch the bus before the pause of the
+ * previous step is over and end up with the firmware running, on a cold
+ * start, a warm start and a warm start with a damaged firmware.
+ */
+#include "esp_lcd_gsl3680.c"
+#include "mock_gsl3680.h"
+#include "gsl3680_fw_blob.h"
+
+#define RST_GPIO        1
+#define INT_GPIO        2
+/* how often the main loop calls the poll */
+#define LOOP_US         1000
+/* the longest transfer: a full burst of firmware */
+#define XFER_MAX_US     (50 + 23 * ESP_LCD_TOUCH_GSL3680_FW_BURST_WORDS_MAX * 4)
+
+static uint8_t table_image[MOCK_PAGES][MOCK_PAGE_SIZE];
+static unsigned failures;
+
+#define EXPECT(cond, ...) do {                  \
+        if (!(cond)) {                          \
+            failures++;                         \
+            printf("FAIL: " __VA_ARGS__);       \
+            printf("\n");                       \
+        }                                       \
+    } while (0)
+
+struct run {
+    esp_err_t ret;
+    int64_t elapsed_us;
+    int64_t idle_us;            /* time between polls, where the pauses go */
+    int64_t longest_poll_us;
+    unsigned polls;
+    unsigned busy_polls;        /* polls that used the bus */
+    unsigned early_polls;       /* polls before the step was due that used the bus anyway */
+};
+
+static uint32_t script_ms(const gsl3680_step_t *script, size_t len)
+{
+    uint32_t ms = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        ms += script[i].delay_ms;
+    }
+    return ms;
+}
+
+static esp_lcd_touch_handle_t new_panel(esp_lcd_touch_io_gsl3680_config_t *gsl_cfg, bool pins)
+{
+    esp_lcd_touch_config_t cfg = {
+        .x_max = 800,
+        .y_max = 1280,
+        .rst_gpio_num = pins ? RST_GPIO : GPIO_NUM_NC,
+        .int_gpio_num = pins ? INT_GPIO : GPIO_NUM_NC,
+        .driver_data = gsl_cfg,
+    };
+    esp_lcd_touch_handle_t tp = NULL;
+
+    EXPECT(esp_lcd_touch_new_i2c_gsl3680_async(mock_io(), &cfg, &tp) == ESP_OK, "async constructor failed");
+    return tp;
+}
+
+/* Poll every LOOP_US until the bring-up ends, at most 10 s */
+static struct run bring_up(esp_lcd_touch_handle_t tp)
+{
+    gsl3680_dev_t *dev = GSL3680_DEV(tp);
+    struct run run = { .ret = ESP_ERR_NOT_FINISHED };
+    const int64_t start = mock.now_us;
+
+    mock_clear_counters();
+    while (run.ret == ESP_ERR_NOT_FINISHED && mock.now_us - start < 10000000) {
+        const int64_t before = mock.now_us;
+        const unsigned xfers = mock.writes + mock.reads;
+        const bool due = before >= dev->bringup.wake_us;
+
+        run.ret = esp_lcd_touch_gsl3680_bringup_poll(tp);
+        run.polls++;
+        if (mock.now_us - before > run.longest_poll_us) {
+            run.longest_poll_us = mock.now_us - before;
+        }
+        if (mock.writes + mock.reads != xfers) {
+            run.busy_polls++;
+            run.early_polls += !due;
+        }
+        if (run.ret == ESP_ERR_NOT_FINISHED) {
+            mock.now_us += LOOP_US;
+            run.idle_us += LOOP_US;
+        }
+    }
+    run.elapsed_us = mock.now_us - start;
+    return run;
+}
+
+static void check_polling(const char *name, const struct run *run)
+{
+    printf("%s: 0x%x after %u polls, %u with bus traffic, %lld us, longest poll %lld us\n", name, run->ret,
+           run->polls, run->busy_polls, (long long)run->elapsed_us, (long long)run->longest_poll_us);
+    EXPECT(run->longest_poll_us <= ESP_LCD_TOUCH_GSL3680_BRINGUP_SLICE_US + XFER_MAX_US,
+           "%s: a poll blocked for %lld us", name, (long long)run->longest_poll_us);
+    EXPECT(run->early_polls == 0, "%s: %u polls used the bus before their step was due", name, run->early_polls);
+}
+
+/* The finished state answers without touching the bus */
+static void check_settled(const char *name, esp_lcd_touch_handle_t tp, esp_err_t want)
+{
+    const unsigned xfers = mock.writes + mock.reads;
+
+    EXPECT(esp_lcd_touch_gsl3680_bringup_poll(tp) == want, "%s: poll after the end changed its result", name);
+    EXPECT(mock.writes + mock.reads == xfers, "%s: poll after the end used the bus", name);
+}
+
+static void test_cold(void)
+{
+    esp_lcd_touch_io_gsl3680_config_t gsl_cfg = { 0 };
+    esp_lcd_touch_gsl3680_boot_info_t info = { 0 };
+    /* every pause of the cold sequence, the firmware upload itself has none */
+    const uint32_t pause_ms = script_ms(GSL_SCRIPT(gsl3680_power_on_script)) +
+                              script_ms(GSL_SCRIPT(gsl3680_read_cfg_script)) +
+                              script_ms(GSL_SCRIPT(gsl3680_clear_reg_script)) +
+                              2 * script_ms(GSL_SCRIPT(gsl3680_reset_script)) +
+                              2 * script_ms(GSL_SCRIPT(gsl3680_startup_script)) +
+                              script_ms(GSL_SCRIPT(gsl3680_read_ram_fw_script));
+    esp_lcd_touch_handle_t tp;
+    struct run run;
+
+    mock_power_on();
+    tp = new_panel(&gsl_cfg, true);
+    run = bring_up(tp);
+    check_polling("cold", &run);
+    EXPECT(run.ret == ESP_OK, "cold: bring-up failed with 0x%x", run.ret);
+    EXPECT(run.idle_us >= (int64_t)pause_ms * 1000, "cold: %lld us between polls, the pauses add up to %u ms",
+           (long long)run.idle_us, (unsigned)pause_ms);
+    EXPECT(!mock_fw_differs(table_image), "cold: RAM does not hold GSLX680_FW");
+    EXPECT(mock.running, "cold: core not released");
+    EXPECT(mock.rst_level == 1, "cold: reset still asserted");
+    /* the upload is sliced, it cannot have gone out in a single poll */
+    EXPECT(run.busy_polls > mock.fw_bytes / (ESP_LCD_TOUCH_GSL3680_BRINGUP_SLICE_US / 23) / 2,
+           "cold: %u busy polls for %u firmware bytes", run.busy_polls, mock.fw_bytes);
+    esp_lcd_touch_gsl3680_get_boot_info(tp, &info);
+    EXPECT(!info.fw_reused && info.fw_load_us > 0, "cold: boot info reused %d, load %u us", info.fw_reused,
+           (unsigned)info.fw_load_us);
+    check_settled("cold", tp, ESP_OK);
+    tp->del(tp);
+}
+
+static void test_warm(void)
+{
+    esp_lcd_touch_io_gsl3680_config_t gsl_cfg = {
+        .fw_sig_page = GSL3680_FW_SIG_PAGE,
+        .fw_sig_start = GSL3680_FW_SIG_START,
+        .fw_sig_words = GSL3680_FW_SIG_WORDS,
+        .fw_sig_digest = GSL3680_FW_SIG_DIGEST,
+    };
+    esp_lcd_touch_gsl3680_boot_info_t info = { 0 };
+    esp_lcd_touch_handle_t tp;
+    struct run cold, warm;
+
+    /* first boot uploads, a restart of the host finds the firmware still there */
+    mock_power_on();
+    tp = new_panel(&gsl_cfg, true);
+    cold = bring_up(tp);
+    tp->del(tp);
+    EXPECT(cold.ret == ESP_OK, "first boot failed with 0x%x", cold.ret);
+
+    tp = new_panel(&gsl_cfg, true);
+    warm = bring_up(tp);
+    check_polling("warm", &warm);
+    EXPECT(warm.ret == ESP_OK, "warm: bring-up failed with 0x%x", warm.ret);
+    EXPECT(mock.fw_writes == 0, "warm: %u firmware writes", mock.fw_writes);
+    EXPECT(warm.elapsed_us < cold.elapsed_us, "warm: %lld us, cold took %lld us", (long long)warm.elapsed_us,
+           (long long)cold.elapsed_us);
+    esp_lcd_touch_gsl3680_get_boot_info(tp, &info);
+    EXPECT(info.fw_reused && info.fw_verify_us > 0, "warm: boot info reused %d, verify %u us", info.fw_reused,
+           (unsigned)info.fw_verify_us);
+    tp->del(tp);
+
+    /* one flipped bit in the signature words and the firmware goes up again */
+    mock.ram[GSL3680_FW_SIG_PAGE][GSL3680_FW_SIG_START + 5] ^= 1;
+    tp = new_panel(&gsl_cfg, true);
+    warm = bring_up(tp);
+    check_polling("damaged", &warm);
+    EXPECT(warm.ret == ESP_OK, "damaged: bring-up failed with 0x%x", warm.ret);
+    EXPECT(!mock_fw_differs(table_image), "damaged: RAM does not hold GSLX680_FW");
+    esp_lcd_touch_gsl3680_get_boot_info(tp, &info);
+    EXPECT(!info.fw_reused, "damaged: firmware reused");
+    tp->del(tp);
+}
+
+static void test_no_pins(void)
+{
+    esp_lcd_touch_io_gsl3680_config_t gsl_cfg = { .fw_blob = gsl3680_fw_blob, .fw_blob_len = sizeof(gsl3680_fw_blob) };
+    esp_lcd_touch_handle_t tp;
+    struct run run;
+
+    mock_power_on();
+    tp = new_panel(&gsl_cfg, false);
+    run = bring_up(tp);
+    check_polling("no pins, packed", &run);
+    EXPECT(run.ret == ESP_OK, "no pins: bring-up failed with 0x%x", run.ret);
+    EXPECT(!mock_fw_differs(table_image), "no pins: RAM does not hold GSLX680_FW");
+    tp->del(tp);
+}
+
+static void test_dead(void)
+{
+    esp_lcd_touch_io_gsl3680_config_t gsl_cfg = { 0 };
+    esp_lcd_touch_handle_t tp;
+    struct run run;
+
+    /* the core never reports 0x5a5a5a5a: the bring-up fails once and stays failed */
+    mock_power_on();
+    mock.boots = false;
+    tp = new_panel(&gsl_cfg, true);
+    run = bring_up(tp);
+    check_polling("dead", &run);
+    EXPECT(run.ret == ESP_FAIL, "dead: bring-up ended with 0x%x", run.ret);
+    check_settled("dead", tp, ESP_FAIL);
+    tp->del(tp);
+}
+
+static void test_blocking(void)
+{
+    esp_lcd_touch_io_gsl3680_config_t gsl_cfg = { 0 };
+    esp_lcd_touch_config_t cfg = {
+        .rst_gpio_num = RST_GPIO,
+        .int_gpio_num = INT_GPIO,
+        .driver_data = &gsl_cfg,
+    };
+    esp_lcd_touch_handle_t tp = NULL;
+
+    /* the blocking constructor runs the same steps, sleeping through the pauses */
+    mock_power_on();
+    EXPECT(esp_lcd_touch_new_i2c_gsl3680(mock_io(), &cfg, &tp) == ESP_OK, "blocking: constructor failed");
+    EXPECT(tp != NULL && !mock_fw_differs(table_image), "blocking: RAM does not hold GSLX680_FW");
+    if (tp != NULL) {
+        tp->del(tp);
+    }
+}
+
+int main(void)
+{
+    mock_table_image(table_image);
+    test_cold();
+    test_warm();
+    test_no_pins();
+    test_dead();
+    test_blocking();
+
+    if (failures) {
+        printf("%u failures\n", failures);
+        return 1;
+    }
+    printf("bring-up polls stay within their slice and pauses\n");
+    return 0;
+}
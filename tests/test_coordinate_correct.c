@@ -0,0 +1,235 @@
+/*
+ * CoordinateCorrect() with the tables of CoordinateCorrectInit() against the
+ * vendor version, which decoded the config for every frame, on 400 random
+ * configs: every x up to 65535 (ex mode), every y up to 4095, active off and on.
+ * The first 49 configs take every kx / ky pair in 0..6.
+ */
+#include <stdio.h>
+#include "gsl_point_id.c"
+#include "gsl_config_data.h"
+
+#define CONFIGS 400
+
+/* CoordinateCorrect() as the vendor wrote it */
+static void CoordinateCorrectRef(struct gsl_alg_ctx *ctx)
+{
+	struct MULTI_TYPE {
+		unsigned int range;
+		unsigned int group;
+	};
+#ifdef LINE_MULTI_SIZE
+#define LINE_SIZE LINE_MULTI_SIZE
+#else
+#define LINE_SIZE 4
+#endif
+	int i, j;
+	unsigned int *px[LINE_SIZE + 1], *py[LINE_SIZE + 1];
+	struct MULTI_TYPE multi_x[LINE_SIZE], multi_y[LINE_SIZE];
+	unsigned int edge_size = 64;
+	int kx, ky;
+
+	if ((coordinate_correct_able & 0xf) == 0)
+		return;
+	kx = (coordinate_correct_able >> 4) & 0xf;
+	ky = (coordinate_correct_able >> 8) & 0xf;
+	px[0] = coordinate_correct_coe_x;
+	py[0] = coordinate_correct_coe_y;
+	for (i = 0; i < LINE_SIZE; i++) {
+		px[i + 1] = NULL;
+		py[i + 1] = NULL;
+		multi_x[i].range = 0;
+		multi_x[i].group = 0;
+		multi_y[i].range = 0;
+		multi_y[i].group = 0;
+	}
+	if (kx == 3 || ky == 3 || kx == 4 || ky == 4) {
+		i = 0;
+		if (kx == 3 || kx == 4)
+			px[1] = multi_group[i++];
+		if (ky == 3 || ky == 4)
+			py[1] = multi_group[i++];
+	} else {
+		for (i = 0; i < LINE_SIZE; i++) {
+			multi_x[i].range = multi_x_array[i] & 0xffff;
+			multi_x[i].group = multi_x_array[i] >> 16;
+			multi_y[i].range = multi_y_array[i] & 0xffff;
+			multi_y[i].group = multi_y_array[i] >> 16;
+		}
+		j = 1;
+		for (i = 0; i < LINE_SIZE; i++)
+			if (multi_x[i].range && multi_x[i].group < LINE_SIZE)
+				px[j++] = multi_group[multi_x[i].group];
+		j = 1;
+		for (i = 0; i < LINE_SIZE; i++)
+			if (multi_y[i].range && multi_y[i].group < LINE_SIZE)
+				py[j++] = multi_group[multi_y[i].group];
+	}
+	for (i = 0; i < (int)point_num && i < POINT_MAX; i++) {
+		if (point_now[i].all == 0)
+			break;
+		if (point_now[i].other.key != 0)
+			continue;
+		if (point_now[i].other.x >= edge_size &&
+		    point_now[i].other.x <= drv_num_nokey * 64 - edge_size) {
+			if (global_state.other.active) {
+				point_now[i].other.x =
+					CCO(point_now[i].other.x,
+					    multi_group[LINE_SIZE - 2], 2);
+			} else if ((kx == 3 || kx == 4) &&
+				   global_state.other.cc_128) {
+				point_now[i].other.x =
+					CC128(point_now[i].other.x, px, kx);
+			} else if (kx == 3) {
+				if (point_now[i].other.x & 64)
+					point_now[i].other.x = CCO(
+						point_now[i].other.x, px[0], 2);
+				else
+					point_now[i].other.x = CCO(
+						point_now[i].other.x, px[1], 2);
+			} else {
+				for (j = 0; j < LINE_SIZE + 1; j++) {
+					if (!(j >= LINE_SIZE ||
+					      px[j + 1] == NULL ||
+					      multi_x[j].range == 0 ||
+					      point_now[i].other.x <
+						      multi_x[j].range))
+						continue;
+					point_now[i].other.x =
+						CCO(point_now[i].other.x, px[j],
+						    kx);
+					break;
+				}
+			}
+		}
+		if (point_now[i].other.y >= edge_size &&
+		    point_now[i].other.y <= sen_num_nokey * 64 - edge_size) {
+			if (global_state.other.active) {
+				point_now[i].other.y =
+					CCO(point_now[i].other.y,
+					    multi_group[LINE_SIZE - 1], 2);
+			} else if ((ky == 3 || ky == 4) &&
+				   global_state.other.cc_128) {
+				point_now[i].other.y =
+					CC128(point_now[i].other.y, py, ky);
+			} else if (ky == 3) {
+				if (point_now[i].other.y & 64)
+					point_now[i].other.y = CCO(
+						point_now[i].other.y, py[0], 2);
+				else
+					point_now[i].other.y = CCO(
+						point_now[i].other.y, py[1], 2);
+			} else {
+				for (j = 0; j < LINE_SIZE + 1; j++) {
+					if (!(j >= LINE_SIZE ||
+					      py[j + 1] == NULL ||
+					      multi_y[j].range == 0 ||
+					      point_now[i].other.y <
+						      multi_y[j].range))
+						continue;
+					point_now[i].other.y =
+						CCO(point_now[i].other.y, py[j],
+						    ky);
+					break;
+				}
+			}
+		}
+	}
+#undef LINE_SIZE
+}
+
+static unsigned int rs;
+
+static unsigned int Rand(void)
+{
+	rs = rs * 1103515245 + 12345;
+	return rs >> 8;
+}
+
+/* random correction settings, drv/sen counts and multi groups */
+static void RandomConfig(struct gsl_alg_ctx *ctx, int c)
+{
+	unsigned int kx, ky, big;
+	int i, j;
+
+	rs = c * 7919 + 1;
+	kx = Rand() % 7;
+	ky = Rand() % 7;
+	if (c < 49) {
+		kx = c % 7;
+		ky = c / 7;
+	}
+	coordinate_correct_able = 1 | kx << 4 | ky << 8;
+	/* coefficients above 64 turn on cc_128 */
+	big = Rand() % 2;
+	for (i = 0; i < 64; i++) {
+		coordinate_correct_coe_x[i] = Rand() % (big ? 128 : 65);
+		coordinate_correct_coe_y[i] = Rand() % (big ? 128 : 65);
+	}
+	for (i = 0; i < 4; i++) {
+		multi_x_array[i] = (Rand() % 3 ? Rand() % 4096 : 0) |
+				   (Rand() % 6) << 16;
+		multi_y_array[i] = (Rand() % 3 ? Rand() % 4096 : 0) |
+				   (Rand() % 6) << 16;
+		for (j = 0; j < 64; j++)
+			multi_group[i][j] = Rand() % 256;
+	}
+	/* mostly real panels, sometimes an ex mode x range */
+	drv_num_nokey = Rand() % 3 ? 1 + Rand() % 80 : Rand() % 1100;
+	sen_num_nokey = 1 + Rand() % 80;
+}
+
+int main(void)
+{
+	struct gsl_alg_ctx *ctx = &gsl_default_ctx;
+	union gsl_POINT_TYPE in[2], want[2];
+	unsigned int failures = 0;
+	unsigned int cc_128, v;
+	int c, active, i;
+
+	gsl_DataInit(gsl_config_data_id);
+	for (c = 0; c < CONFIGS; c++) {
+		RandomConfig(ctx, c);
+		gsl_id_reg_init(ctx, 0);
+		CoordinateCorrectInit(ctx);
+		cc_128 = global_state.other.cc_128;
+		for (active = 0; active < 2; active++) {
+			global_state.all = 0;
+			global_state.other.cc_128 = cc_128;
+			global_state.other.active = active;
+			for (v = 0; v < 65536; v++) {
+				in[0].all = 0;
+				in[0].other.x = v;
+				in[0].other.y = v & 0xfff;
+				in[1].all = 0;
+				in[1].other.x = v ^ 0x555;
+				in[1].other.y = (v >> 4) & 0xfff;
+
+				point_num = 2;
+				point_now[0] = in[0];
+				point_now[1] = in[1];
+				CoordinateCorrectRef(ctx);
+				want[0] = point_now[0];
+				want[1] = point_now[1];
+
+				point_now[0] = in[0];
+				point_now[1] = in[1];
+				CoordinateCorrect(ctx);
+				for (i = 0; i < 2; i++) {
+					if (point_now[i].all != want[i].all &&
+					    failures++ < 10)
+						printf("FAIL: config %d active %d (%u, %u) gave (%u, %u), expected (%u, %u)\n",
+						       c, active, in[i].other.x, in[i].other.y,
+						       point_now[i].other.x, point_now[i].other.y,
+						       want[i].other.x, want[i].other.y);
+				}
+			}
+		}
+	}
+
+	if (failures) {
+		printf("%u mismatches\n", failures);
+		return 1;
+	}
+	printf("CoordinateCorrect matches the vendor version on %d configs\n", CONFIGS);
+	return 0;
+}
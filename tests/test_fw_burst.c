@@ -0,0 +1,128 @@
+/*
+ * Firmware upload against the per-word reference: every burst size of the
+ * table path and of the packed blob must leave the same firmware in the
+ * controller RAM as writing GSLX680_FW one word at a time.
+ */
+#include "esp_lcd_gsl3680.c"
+#include "mock_gsl3680.h"
+#include "gsl3680_fw_blob.h"
+
+static uint8_t reference[MOCK_PAGES][MOCK_PAGE_SIZE];
+static unsigned failures;
+
+#define EXPECT(cond, ...) do {                  \
+        if (!(cond)) {                          \
+            failures++;                         \
+            printf("FAIL: " __VA_ARGS__);       \
+            printf("\n");                       \
+        }                                       \
+    } while (0)
+
+/* Upload in bring-up slices, returns the words written */
+static size_t upload(esp_lcd_touch_io_gsl3680_config_t *cfg, unsigned *writes)
+{
+    esp_lcd_touch_t tp = { 0 };
+    gsl3680_fw_cursor_t fw = { .page = -1 };
+    esp_err_t ret;
+
+    tp.io = mock_io();
+    tp.config.driver_data = cfg;
+    mock_power_on();
+    do {
+        ret = esp_lcd_touch_gsl3680_load_fw(&tp, &fw, ESP_LCD_TOUCH_GSL3680_BRINGUP_SLICE_US);
+    } while (ret == ESP_ERR_NOT_FINISHED);
+    EXPECT(ret == ESP_OK, "upload failed with 0x%x", ret);
+    EXPECT(fw.writes == mock.writes, "cursor counted %u writes, bus saw %u", (unsigned)fw.writes, mock.writes);
+    *writes = mock.writes;
+    return fw.words;
+}
+
+static void check_burst(const char *path, esp_lcd_touch_io_gsl3680_config_t *cfg, size_t burst_max,
+                        size_t words_ref, unsigned writes_ref)
+{
+    unsigned writes;
+    size_t words = upload(cfg, &writes);
+
+    printf("%s burst %u: %u writes\n", path, cfg->fw_burst_words, writes);
+    EXPECT(!mock_fw_differs(reference), "%s burst %u: RAM differs from the per-word upload", path, cfg->fw_burst_words);
+    EXPECT(words == words_ref, "%s burst %u: %u words, expected %u", path, cfg->fw_burst_words, (unsigned)words, (unsigned)words_ref);
+    EXPECT(mock.max_fw_write <= burst_max * 4, "%s burst %u: %u byte write", path, cfg->fw_burst_words, (unsigned)mock.max_fw_write);
+    EXPECT(!mock.fw_write_out_of_page, "%s burst %u: write past the firmware registers", path, cfg->fw_burst_words);
+    if (burst_max > 1) {
+        EXPECT(writes < writes_ref, "%s burst %u: %u writes, per-word upload took %u", path, cfg->fw_burst_words, writes, writes_ref);
+    }
+}
+
+/* Segments with gaps, odd starts and a page revisited, which GSLX680_FW does not
+ * have: every page of it is one run from 0x00 */
+static void check_packed_gaps(void)
+{
+    static const uint8_t blob[] = {
+        3, 0x10, 3, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12,
+        3, 0x40, 5, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+        7, 0x7c, 1, 41, 42, 43, 44,
+        3, 0x00, 2, 51, 52, 53, 54, 55, 56, 57, 58,
+    };
+    static const uint8_t bursts[] = { 1, 2, 32 };
+    static uint8_t image[MOCK_PAGES][MOCK_PAGE_SIZE];
+    esp_lcd_touch_io_gsl3680_config_t cfg = { .fw_blob = blob, .fw_blob_len = sizeof(blob) };
+    size_t pos;
+    unsigned writes;
+
+    memset(image, 0, sizeof(image));
+    for (pos = 0; pos < sizeof(blob); pos += 3 + blob[pos + 2] * 4) {
+        memcpy(&image[blob[pos]][blob[pos + 1]], &blob[pos + 3], blob[pos + 2] * 4);
+    }
+    for (size_t i = 0; i < sizeof(bursts); i++) {
+        cfg.fw_burst_words = bursts[i];
+        EXPECT(upload(&cfg, &writes) == 11, "gaps burst %u: wrong word count", bursts[i]);
+        EXPECT(!mock_fw_differs(image), "gaps burst %u: RAM differs from the segments", bursts[i]);
+        /* a page is selected again only when it changes */
+        EXPECT(writes - mock.fw_writes == 3, "gaps burst %u: %u page selects", bursts[i], writes - mock.fw_writes);
+    }
+}
+
+int main(void)
+{
+    static const uint8_t bursts[] = { 2, 3, 7, 8, 16, 31, 32 };
+    esp_lcd_touch_io_gsl3680_config_t cfg = { 0 };
+    size_t words_ref;
+    unsigned writes_ref;
+
+    /* one write per word and per page select is the vendor upload */
+    mock_table_image(reference);
+    cfg.fw_burst_words = 1;
+    words_ref = upload(&cfg, &writes_ref);
+    EXPECT(!mock_fw_differs(reference), "per-word upload does not match GSLX680_FW");
+    EXPECT(mock.max_fw_write == 4, "per-word upload wrote %u bytes at once", (unsigned)mock.max_fw_write);
+    EXPECT(words_ref + (writes_ref - mock.fw_writes) == sizeof(GSLX680_FW) / sizeof(GSLX680_FW[0]),
+           "per-word upload skipped table entries");
+    printf("table burst 1: %u writes\n", writes_ref);
+
+    for (size_t i = 0; i < sizeof(bursts); i++) {
+        cfg.fw_burst_words = bursts[i];
+        check_burst("table", &cfg, bursts[i], words_ref, writes_ref);
+    }
+    /* 0 takes the default, oversized bursts are capped */
+    cfg.fw_burst_words = 0;
+    check_burst("table", &cfg, ESP_LCD_TOUCH_GSL3680_FW_BURST_WORDS_DEFAULT, words_ref, writes_ref);
+    cfg.fw_burst_words = 200;
+    check_burst("table", &cfg, ESP_LCD_TOUCH_GSL3680_FW_BURST_WORDS_MAX, words_ref, writes_ref);
+
+    cfg.fw_blob = gsl3680_fw_blob;
+    cfg.fw_blob_len = sizeof(gsl3680_fw_blob);
+    cfg.fw_burst_words = 1;
+    check_burst("packed", &cfg, 1, words_ref, writes_ref);
+    for (size_t i = 0; i < sizeof(bursts); i++) {
+        cfg.fw_burst_words = bursts[i];
+        check_burst("packed", &cfg, bursts[i], words_ref, writes_ref);
+    }
+    check_packed_gaps();
+
+    if (failures) {
+        printf("%u failures\n", failures);
+        return 1;
+    }
+    printf("every burst size uploads the same firmware\n");
+    return 0;
+}
@@ -0,0 +1,91 @@
+/*
+ * RecipDiv() against C division.
+ *
+ * n * m >> s never decreases as n grows, so it equals n / d for every n in
+ * [0, limit] once it does at both ends of each run q * d .. q * d + d - 1.
+ * Checking those ends covers the whole range in about 2 * limit / d calls.
+ */
+#include <limits.h>
+#include <stdio.h>
+#include "gsl_point_id.c"
+#include "gsl_config_data.h"
+
+/* the largest 12 bit coordinate times the largest 12 bit screen size */
+#define COORD_LIMIT (4095LL * 4095)
+
+static unsigned int failures;
+
+static void expect(const struct gsl_RECIP_TYPE *r, int n, int q)
+{
+	int got = RecipDiv(r, n);
+
+	if (got != q && failures++ < 10)
+		printf("FAIL: %d / %d gave %d, expected %d\n", n, r->d, got, q);
+}
+
+/* every n with |n| <= limit */
+static void check_range(int d, long long limit)
+{
+	struct gsl_RECIP_TYPE r;
+	long long q, n;
+
+	RecipInit(&r, d);
+	if (r.m == 0 && failures++ < 10)
+		printf("FAIL: %d has no reciprocal\n", d);
+	for (q = 0; q * d <= limit; q++) {
+		n = q * d;
+		expect(&r, (int)n, (int)q);
+		expect(&r, (int)-n, (int)-q);
+		n = n + d - 1 < limit ? n + d - 1 : limit;
+		expect(&r, (int)n, (int)q);
+		expect(&r, (int)-n, (int)-q);
+	}
+}
+
+int main(void)
+{
+	struct gsl_alg_ctx *ctx = &gsl_default_ctx;
+	struct gsl_RECIP_TYPE r;
+	int d, i;
+
+	/* screen sizes, grid sizes and the other config divisors all stay below 2^12 */
+	for (d = 1; d < 4096; d++)
+		check_range(d, COORD_LIMIT);
+
+	/* distance scaling multiplies before it divides, the grid sizes get the full range */
+	for (d = 64; d < 4096; d += 64)
+		check_range(d, INT_MAX);
+
+	gsl_DataInit(gsl_config_data_id);
+	check_range(recip_res_x.d, INT_MAX);
+	check_range(recip_res_y.d, INT_MAX);
+	check_range(recip_diagonal.d, INT_MAX);
+	check_range((int)screen_x_max, INT_MAX);
+	check_range((int)screen_y_max, INT_MAX);
+	for (i = 0; i < 4; i++) {
+		if (filter_fir[i].den.d > 0)
+			check_range(filter_fir[i].den.d, INT_MAX);
+	}
+
+	/* no reciprocal for d <= 0 or INT_MIN, those divide; a stale shift
+	 * from an earlier divisor must not survive either */
+	RecipInit(&r, 3);
+	RecipInit(&r, 0);
+	if ((r.m != 0 || r.s != 0) && failures++ < 10)
+		printf("FAIL: 0 has a reciprocal\n");
+	RecipInit(&r, -7);
+	if ((r.m != 0 || r.s != 0) && failures++ < 10)
+		printf("FAIL: -7 has a reciprocal\n");
+	expect(&r, 100, 100 / -7);
+	expect(&r, -100, -100 / -7);
+	RecipInit(&r, 3);
+	expect(&r, INT_MIN, INT_MIN / 3);
+	expect(&r, INT_MAX, INT_MAX / 3);
+
+	if (failures) {
+		printf("%u mismatches\n", failures);
+		return 1;
+	}
+	printf("RecipDiv matches C division\n");
+	return 0;
+}
@@ -0,0 +1,36 @@
+/*
+ * Sqrt() for every int from -5 up: floor(sqrt(d)), 0 below 1, clamped to
+ * 32767. Built once with the table and once with GSL_SQRT_BITWISE, so both
+ * builds are checked against the same reference and so against each other.
+ */
+#include <limits.h>
+#include <stdio.h>
+#include "gsl_point_id.c"
+
+int main(void)
+{
+	unsigned int failures = 0;
+	long long r = 0;
+	int d = -5;
+
+	for (;;) {
+		int want;
+		int got = Sqrt(d);
+
+		while ((r + 1) * (r + 1) <= d)
+			r++;
+		want = r < 32767 ? (int)r : 32767;
+		if (got != want && failures++ < 10)
+			printf("FAIL: Sqrt(%d) gave %d, expected %d\n", d, got, want);
+		if (d == INT_MAX)
+			break;
+		d++;
+	}
+
+	if (failures) {
+		printf("%u mismatches\n", failures);
+		return 1;
+	}
+	printf("Sqrt matches floor(sqrt(d)) from -5 to %d\n", INT_MAX);
+	return 0;
+}
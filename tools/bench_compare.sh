@@ -0,0 +1,74 @@
+#!/bin/sh
+# Compare the per-stage cost of gsl_point_id.c between two git revisions.
+#
+# Builds tools/gsl_bench.c of the working tree against gsl_point_id.c and
+# gsl_point_id.h taken from each revision, runs the two binaries in turn and
+# prints, for every workload and stage, the smallest median over all runs.
+# The minimum is what stays comparable on a busy host.
+#
+# usage: tools/bench_compare.sh [-f fingers] [-r runs] <rev-a> <rev-b>
+#   -f  only the workloads with this many fingers, as gsl_bench -f
+#   -r  runs of each binary, default 25
+#
+# CC and BENCH_CFLAGS pick the compiler and flags, by default gcc with
+# auto-vectorisation off as on the targets. Example, the one finger case of
+# the occupied slot walks:
+#   tools/bench_compare.sh -f 1 01db62c^ 01db62c
+set -e
+
+fingers=
+runs=25
+while getopts f:r: opt; do
+    case $opt in
+    f) fingers="-f $OPTARG" ;;
+    r) runs=$OPTARG ;;
+    *) echo "usage: $0 [-f fingers] [-r runs] <rev-a> <rev-b>" >&2; exit 2 ;;
+    esac
+done
+shift $((OPTIND - 1))
+if [ $# -ne 2 ]; then
+    echo "usage: $0 [-f fingers] [-r runs] <rev-a> <rev-b>" >&2
+    exit 2
+fi
+
+top=$(git rev-parse --show-toplevel)
+comp=$top/components/gsl3680
+cc=${CC:-gcc}
+cflags=${BENCH_CFLAGS:--O2 -fno-tree-vectorize -fno-tree-slp-vectorize}
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+build() {
+    mkdir -p "$tmp/$2"
+    git -C "$top" show "$1:components/gsl3680/gsl_point_id.c" > "$tmp/$2/gsl_point_id.c"
+    git -C "$top" show "$1:components/gsl3680/gsl_point_id.h" > "$tmp/$2/gsl_point_id.h"
+    # the revision's header first, gsl_config_data.h from the working tree
+    $cc $cflags -DGSL_STAGE_PROFILE -I"$tmp/$2" -I"$comp" -o "$tmp/$2/gsl_bench" \
+        "$top/tools/gsl_bench.c" "$tmp/$2/gsl_point_id.c" "$comp/gsl_config_data.c"
+}
+
+build "$1" a
+build "$2" b
+
+i=0
+while [ $i -lt "$runs" ]; do
+    for side in a b; do
+        "$tmp/$side/gsl_bench" $fingers 2>/dev/null | sed "s/^/$side /"
+    done
+    i=$((i + 1))
+done | awk -v ra="$1" -v rb="$2" '
+    $2 == "#" { work = $3 " fingers " $5; if (!(work in seen)) { seen[work] = 1; works[nw++] = work }; next }
+    NF == 5 && $3 ~ /^[0-9]+$/ {
+        key = work SUBSEP $2
+        if (!(key in order)) { order[key] = ns[work]++; stage[work, ns[work] - 1] = $2 }
+        if (!(($1, key) in best) || $4 < best[$1, key]) best[$1, key] = $4
+    }
+    END {
+        for (w = 0; w < nw; w++) {
+            printf "%-22s %10s %10s\n", works[w], ra, rb
+            for (s = 0; s < ns[works[w]]; s++) {
+                key = works[w] SUBSEP stage[works[w], s]
+                printf "  %-20s %10s %10s\n", stage[works[w], s], best["a", key], best["b", key]
+            }
+        }
+    }'
@@ -0,0 +1,44 @@
+"""Write the packed firmware and its signature as a C header for host builds.
+
+usage: firmware_header.py OUTPUT
+
+The blob and the signature come from components/gsl3680/firmware.py, the same
+code that generates them for the ESPHome build.
+"""
+
+from pathlib import Path
+import sys
+
+sys.dont_write_bytecode = True
+sys.path.insert(0, str(Path(__file__).resolve().parent.parent / "components" / "gsl3680"))
+
+from firmware import firmware_signature, pack_firmware, parse_firmware  # noqa: E402
+
+
+def main(output):
+    entries = parse_firmware()
+    blob = pack_firmware(entries)
+    page, start, words, digest = firmware_signature(entries)
+
+    lines = [
+        "/* Generated by tools/firmware_header.py from esp_lcd_gsl3680.h, do not edit */",
+        "#pragma once",
+        "#include <stdint.h>",
+        "",
+        f"#define GSL3680_FW_SIG_PAGE     0x{page:02x}",
+        f"#define GSL3680_FW_SIG_START    0x{start:02x}",
+        f"#define GSL3680_FW_SIG_WORDS    {words}",
+        f"#define GSL3680_FW_SIG_DIGEST   0x{digest:08x}u",
+        "",
+        "static const uint8_t gsl3680_fw_blob[] = {",
+    ]
+    for i in range(0, len(blob), 16):
+        lines.append("    " + " ".join(f"0x{b:02x}," for b in blob[i : i + 16]))
+    lines.append("};")
+    Path(output).write_text("\n".join(lines) + "\n", encoding="utf-8")
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    main(sys.argv[1])
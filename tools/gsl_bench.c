@@ -0,0 +1,153 @@
+/*
+ * Per-stage cost of the point id algorithm on synthetic touches.
+ *
+ * Needs gsl_point_id.c built with -DGSL_STAGE_PROFILE. Each workload runs on
+ * a fresh context: 0, 1, 2, 5 and 10 fingers moving slow (2 units per frame)
+ * or fast (40 units per frame) with one unit of jitter, bouncing off the
+ * panel edges. After the warm-up frames the profile is reset and the next
+ * frames are measured; every stage then prints its median and p99 in the
+ * units of the profile clock (CPU cycles on the ESP target, TSC ticks on an
+ * x86 host). Keep the measured frames at or below GSL_STAGE_PROFILE_SAMPLES
+ * so the figures cover all of them.
+ *
+ * Output, one block per workload:
+ *   # <fingers> fingers <slow|fast>
+ *   <stage> <calls> <median> <p99>
+ *
+ * usage: gsl_bench [-w warmup] [-n frames] [-f fingers]
+ *   -w  frames run before the profile is reset, default 1000
+ *   -n  frames measured, default 128
+ *   -f  only the workloads with this many fingers
+ *
+ * On the target, build the component with -DGSL_STAGE_PROFILE and add this
+ * file to a test app: app_main() runs every workload with the defaults and
+ * prints to the console.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gsl_point_id.h"
+#include "gsl_config_data.h"
+
+#define MAX_FINGER_NUM  10
+#define STAGE_MAX       32
+
+static const int bench_fingers[] = { 0, 1, 2, 5, 10 };
+static const int bench_speeds[] = { 2, 40 };
+
+static unsigned int bench_seed;
+
+/* Small LCG so every platform replays the same touches */
+static int bench_jitter(void)
+{
+    bench_seed = bench_seed * 1103515245u + 12345u;
+    return (int)((bench_seed >> 16) % 3) - 1;
+}
+
+static void bench_workload(struct gsl_alg_ctx *ctx, int fingers, int speed, int warmup, int frames)
+{
+    struct gsl_stage_stat stat[STAGE_MAX];
+    int x[MAX_FINGER_NUM], y[MAX_FINGER_NUM], dx[MAX_FINGER_NUM], dy[MAX_FINGER_NUM];
+    int count, i, k;
+
+    memset(ctx, 0, gsl_alg_ctx_size());
+    gsl_DataInit_ctx(ctx, gsl_config_data_id);
+    bench_seed = (unsigned int)(fingers * 10 + speed);
+    for (k = 0; k < MAX_FINGER_NUM; k++) {
+        x[k] = 100 + k * 170;
+        y[k] = 100 + (k % 3) * 400;
+        dx[k] = speed;
+        dy[k] = speed / 2;
+    }
+
+    for (i = 0; i < warmup + frames; i++) {
+        struct gsl_touch_info cinfo = {0};
+
+        if (i == warmup) {
+            gsl_stage_profile_reset_ctx(ctx);
+        }
+        for (k = 0; k < fingers; k++) {
+            x[k] += dx[k] + bench_jitter();
+            y[k] += dy[k] + bench_jitter();
+            if (x[k] < 20 || x[k] > 1900) {
+                dx[k] = -dx[k];
+            }
+            if (y[k] < 20 || y[k] > 1250) {
+                dy[k] = -dy[k];
+            }
+            cinfo.x[k] = x[k];
+            cinfo.y[k] = y[k];
+            cinfo.id[k] = k + 1;
+        }
+        cinfo.finger_num = fingers;
+        gsl_alg_id_main_ctx(ctx, &cinfo);
+        gsl_mask_tiaoping_ctx(ctx);
+    }
+
+    count = gsl_stage_profile_ctx(ctx, stat, STAGE_MAX);
+    printf("# %d fingers %s\n", fingers, speed == bench_speeds[0] ? "slow" : "fast");
+    for (i = 0; i < count && i < STAGE_MAX; i++) {
+        if (stat[i].calls != 0) {
+            printf("%-18s %6u %8u %8u\n", stat[i].name, stat[i].calls, stat[i].median, stat[i].p99);
+        }
+    }
+}
+
+static int bench_run(int warmup, int frames, int only_fingers)
+{
+    struct gsl_alg_ctx *ctx = malloc(gsl_alg_ctx_size());
+    size_t f, v;
+
+    if (ctx == NULL) {
+        printf("no memory for a %u byte context\n", (unsigned)gsl_alg_ctx_size());
+        return 1;
+    }
+    for (f = 0; f < sizeof(bench_fingers) / sizeof(bench_fingers[0]); f++) {
+        if (only_fingers >= 0 && bench_fingers[f] != only_fingers) {
+            continue;
+        }
+        for (v = 0; v < sizeof(bench_speeds) / sizeof(bench_speeds[0]); v++) {
+            bench_workload(ctx, bench_fingers[f], bench_speeds[v], warmup, frames);
+        }
+    }
+    free(ctx);
+    return 0;
+}
+
+#ifdef ESP_PLATFORM
+void app_main(void)
+{
+    bench_run(1000, 128, -1);
+}
+#else
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-w warmup] [-n frames] [-f fingers]\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+    int warmup = 1000;
+    int frames = 128;
+    int only_fingers = -1;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (i + 1 < argc && strcmp(argv[i], "-w") == 0) {
+            warmup = atoi(argv[++i]);
+        } else if (i + 1 < argc && strcmp(argv[i], "-n") == 0) {
+            frames = atoi(argv[++i]);
+        } else if (i + 1 < argc && strcmp(argv[i], "-f") == 0) {
+            only_fingers = atoi(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (warmup < 0 || frames <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    return bench_run(warmup, frames, only_fingers);
+}
+#endif
@@ -0,0 +1,149 @@
+/*
+ * Replay a recorded GSL3680 trace through the point id algorithm on the host
+ * and print what the driver would report.
+ *
+ * A trace has one frame per line: the bytes read from register 0x80 in hex,
+ * the 4 byte header (finger count, then the algorithm flags) followed by 4
+ * bytes per finger. Spaces between bytes are optional, blank lines and text
+ * after '#' are skipped. An idle frame is "00000000".
+ *
+ * Every frame prints one line:
+ *   <frame> <fingers> <tiaoping mask> <id>:<x>,<y> ...
+ * with the mask in hex as gsl_mask_tiaoping() returns it.
+ *
+ * usage: gsl_replay [-l lookahead] [-a] [trace]
+ *   -l  report lookahead in 1/256 frames, as gsl_alg_set_lookahead() takes it
+ *   -a  release settled new fingers early (gsl_alg_set_adaptive_delay())
+ * Without a trace file the frames are read from stdin.
+ */
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gsl_point_id.h"
+#include "gsl_config_data.h"
+
+#define MAX_FINGER_NUM  10
+#define LINE_MAX_LEN    1024
+
+static int hex_digit(int c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c = tolower(c);
+    return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+}
+
+/* Decode the hex bytes of one line, returns the byte count or -1 on bad input */
+static int parse_frame(const char *line, unsigned char *buf, int max)
+{
+    int len = 0;
+    int hi = -1;
+
+    for (; *line != '\0' && *line != '#'; line++) {
+        int d;
+
+        if (isspace((unsigned char)*line)) {
+            if (hi >= 0) {
+                return -1;
+            }
+            continue;
+        }
+        d = hex_digit((unsigned char)*line);
+        if (d < 0) {
+            return -1;
+        }
+        if (hi < 0) {
+            hi = d;
+            continue;
+        }
+        if (len == max) {
+            return -1;
+        }
+        buf[len++] = (unsigned char)(hi << 4 | d);
+        hi = -1;
+    }
+    return hi >= 0 ? -1 : len;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-l lookahead] [-a] [trace]\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+    FILE *in = stdin;
+    unsigned int lookahead = 0;
+    int adaptive_delay = 0;
+    char line[LINE_MAX_LEN];
+    unsigned char buf[4 + MAX_FINGER_NUM * 4];
+    unsigned int line_no = 0;
+    unsigned int frame = 0;
+    int i;
+
+    for (i = 1; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; i++) {
+        if (strcmp(argv[i], "-a") == 0) {
+            adaptive_delay = 1;
+        } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            lookahead = (unsigned int)strtoul(argv[++i], NULL, 0);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (i + 1 < argc) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (i < argc && strcmp(argv[i], "-") != 0) {
+        in = fopen(argv[i], "r");
+        if (in == NULL) {
+            perror(argv[i]);
+            return 1;
+        }
+    }
+
+    gsl_DataInit(gsl_config_data_id);
+    gsl_alg_set_lookahead(lookahead);
+    gsl_alg_set_adaptive_delay(adaptive_delay);
+
+    while (fgets(line, sizeof(line), in) != NULL) {
+        struct gsl_touch_info cinfo = {0};
+        int len, count, k;
+
+        line_no++;
+        if (strchr(line, '\n') == NULL && !feof(in)) {
+            fprintf(stderr, "line %u: too long\n", line_no);
+            return 1;
+        }
+        len = parse_frame(line, buf, sizeof(buf));
+        if (len == 0) {
+            continue;
+        }
+        if (len < 4) {
+            fprintf(stderr, "line %u: expected hex bytes starting with a 4 byte header\n", line_no);
+            return 1;
+        }
+        /* The driver reads the header, then only the fingers it reports */
+        count = buf[0] < MAX_FINGER_NUM ? buf[0] : MAX_FINGER_NUM;
+        if (len != 4 + count * 4) {
+            fprintf(stderr, "line %u: expected a header and %d fingers\n", line_no, count);
+            return 1;
+        }
+
+        gsl_touch_info_from_frame(&cinfo, buf, count);
+        gsl_alg_id_main(&cinfo);
+        printf("%u %d %08x", frame++, cinfo.finger_num, gsl_mask_tiaoping());
+        for (k = 0; k < cinfo.finger_num && k < MAX_FINGER_NUM; k++) {
+            printf(" %d:%d,%d", cinfo.id[k], cinfo.x[k], cinfo.y[k]);
+        }
+        printf("\n");
+    }
+
+    if (in != stdin) {
+        fclose(in);
+    }
+    return 0;
+}
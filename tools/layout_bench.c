@@ -0,0 +1,210 @@
+/*
+ * The point history in two layouts, timed on the scans the algorithm runs:
+ *   rows          one row of packed gsl_POINT_TYPE per frame, a window of
+ *                 row pointers stepped back by one base per frame, as
+ *                 PointPointer() does
+ *   finger-major  int16 x and y and a flag byte per finger and frame, each
+ *                 finger a ring sharing one head: a window of frame
+ *                 offsets stepped back by one head per frame, the same
+ *                 O(1) step as the rows
+ *
+ * Each kernel runs REPEAT times per sample and the smallest of SAMPLES
+ * samples is printed, in profile clock ticks per call (CPU cycles on the
+ * ESP target, TSC ticks on an x86 host). Build it without auto-vectorisation
+ * to match the targets.
+ *
+ * Output: <kernel> <fingers> <rows> <finger-major>
+ */
+#include <stdio.h>
+#include <string.h>
+#include "gsl_point_id.c"
+
+#define REPEAT          2000
+#define SAMPLES         200
+
+static union gsl_POINT_TYPE bench_rows[PP_DEEP][POINT_MAX];
+static union gsl_POINT_TYPE *bench_ring[PP_DEEP * 2];
+static union gsl_POINT_TYPE *bench_win[PP_DEEP];
+static int bench_base;
+
+static struct {
+    short x[POINT_MAX][PP_DEEP];
+    short y[POINT_MAX][PP_DEEP];
+    unsigned char flag[POINT_MAX][PP_DEEP];
+} bench_fm;
+static unsigned char bench_fm_ring[PP_DEEP * 2];
+static unsigned char bench_fm_win[PP_DEEP];
+static int bench_fm_head;
+
+/* frame j of finger i */
+#define FM_X(i, j)      bench_fm.x[i][bench_fm_win[j]]
+#define FM_Y(i, j)      bench_fm.y[i][bench_fm_win[j]]
+#define FM_FLAG(i, j)   bench_fm.flag[i][bench_fm_win[j]]
+
+static volatile int bench_sink;
+
+/* x + 2 * x1 + x2 over the last three frames, as FilterOne() with 3 taps */
+static __attribute__((noinline)) int fir_rows(int n)
+{
+    int acc = 0;
+
+    for (int i = 0; i < n; i++) {
+        acc += (bench_win[0][i].other.x + bench_win[1][i].other.x * 2 + bench_win[2][i].other.x) / 4;
+        acc += (bench_win[0][i].other.y + bench_win[1][i].other.y * 2 + bench_win[2][i].other.y) / 4;
+    }
+    return acc;
+}
+
+static __attribute__((noinline)) int fir_fm(int n)
+{
+    int acc = 0;
+
+    for (int i = 0; i < n; i++) {
+        acc += (FM_X(i, 0) + FM_X(i, 1) * 2 + FM_X(i, 2)) / 4;
+        acc += (FM_Y(i, 0) + FM_Y(i, 1) * 2 + FM_Y(i, 2)) / 4;
+    }
+    return acc;
+}
+
+/* every frame of the history, as the averaging stages read it */
+static __attribute__((noinline)) int hist_rows(int n)
+{
+    int acc = 0;
+
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < PP_DEEP; j++) {
+            acc += bench_win[j][i].other.x + bench_win[j][i].other.y;
+        }
+    }
+    return acc;
+}
+
+static __attribute__((noinline)) int hist_fm(int n)
+{
+    int acc = 0;
+
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < PP_DEEP; j++) {
+            acc += FM_X(i, j) + FM_Y(i, j);
+        }
+    }
+    return acc;
+}
+
+/* three point prediction into the newest frame, flagged as predicted */
+static __attribute__((noinline)) void predict_rows(int n)
+{
+    for (int i = 0; i < n; i++) {
+        union gsl_POINT_TYPE p = {0};
+
+        p.other.x = (bench_win[1][i].other.x * 5 + bench_win[3][i].other.x - bench_win[2][i].other.x * 4) / 2;
+        p.other.y = (bench_win[1][i].other.y * 5 + bench_win[3][i].other.y - bench_win[2][i].other.y * 4) / 2;
+        p.other.predict = 1;
+        bench_win[0][i].all = p.all;
+    }
+}
+
+static __attribute__((noinline)) void predict_fm(int n)
+{
+    for (int i = 0; i < n; i++) {
+        FM_X(i, 0) = (short)((FM_X(i, 1) * 5 + FM_X(i, 3) - FM_X(i, 2) * 4) / 2);
+        FM_Y(i, 0) = (short)((FM_Y(i, 1) * 5 + FM_Y(i, 3) - FM_Y(i, 2) * 4) / 2);
+        FM_FLAG(i, 0) |= 8;
+    }
+}
+
+/* a new frame: both step one base and clear the new frame of every slot */
+static __attribute__((noinline)) void step_rows(void)
+{
+    bench_base = bench_base == 0 ? PP_DEEP - 1 : bench_base - 1;
+    memcpy(bench_win, bench_ring + bench_base, sizeof(bench_win));
+    memset(bench_win[0], 0, sizeof(bench_rows[0]));
+}
+
+static __attribute__((noinline)) void step_fm(void)
+{
+    bench_fm_head = bench_fm_head == 0 ? PP_DEEP - 1 : bench_fm_head - 1;
+    memcpy(bench_fm_win, bench_fm_ring + bench_fm_head, sizeof(bench_fm_win));
+    for (int i = 0; i < POINT_MAX; i++) {
+        FM_X(i, 0) = 0;
+        FM_Y(i, 0) = 0;
+        FM_FLAG(i, 0) = 0;
+    }
+}
+
+#define BENCH_TIME(result, call)                                \
+    do {                                                        \
+        unsigned int best = ~0u;                                \
+        for (int s = 0; s < SAMPLES; s++) {                     \
+            unsigned int t0 = gsl_stage_clock();                \
+            for (int r = 0; r < REPEAT; r++) {                  \
+                call;                                           \
+            }                                                   \
+            t0 = gsl_stage_clock() - t0;                        \
+            best = t0 < best ? t0 : best;                       \
+        }                                                       \
+        result = (double)best / REPEAT;                         \
+    } while (0)
+
+/* Both layouts hold the same random history */
+static void bench_fill(void)
+{
+    unsigned int seed = 1;
+
+    for (int j = 0; j < PP_DEEP; j++) {
+        bench_ring[j] = bench_rows[j];
+        bench_ring[j + PP_DEEP] = bench_rows[j];
+        bench_fm_ring[j] = (unsigned char)j;
+        bench_fm_ring[j + PP_DEEP] = (unsigned char)j;
+        for (int i = 0; i < POINT_MAX; i++) {
+            seed = seed * 1103515245u + 12345u;
+            bench_rows[j][i].other.x = (seed >> 8) % 4096;
+            seed = seed * 1103515245u + 12345u;
+            bench_rows[j][i].other.y = (seed >> 8) % 4096;
+            bench_fm.x[i][j] = (short)bench_rows[j][i].other.x;
+            bench_fm.y[i][j] = (short)bench_rows[j][i].other.y;
+        }
+    }
+    bench_base = 0;
+    memcpy(bench_win, bench_ring, sizeof(bench_win));
+    bench_fm_head = 0;
+    memcpy(bench_fm_win, bench_fm_ring, sizeof(bench_fm_win));
+}
+
+static void bench_layouts(void)
+{
+    static const int fingers[] = { 1, 2, 5, 10 };
+    double rows, fm;
+
+    bench_fill();
+    printf("%-10s %7s %8s %12s\n", "kernel", "fingers", "rows", "finger-major");
+    for (size_t f = 0; f < sizeof(fingers) / sizeof(fingers[0]); f++) {
+        int n = fingers[f];
+
+        BENCH_TIME(rows, bench_sink = fir_rows(n));
+        BENCH_TIME(fm, bench_sink = fir_fm(n));
+        printf("%-10s %7d %8.1f %12.1f\n", "fir3", n, rows, fm);
+        BENCH_TIME(rows, bench_sink = hist_rows(n));
+        BENCH_TIME(fm, bench_sink = hist_fm(n));
+        printf("%-10s %7d %8.1f %12.1f\n", "history", n, rows, fm);
+        BENCH_TIME(rows, predict_rows(n));
+        BENCH_TIME(fm, predict_fm(n));
+        printf("%-10s %7d %8.1f %12.1f\n", "predict3", n, rows, fm);
+    }
+    BENCH_TIME(rows, step_rows());
+    BENCH_TIME(fm, step_fm());
+    printf("%-10s %7d %8.1f %12.1f\n", "step", POINT_MAX, rows, fm);
+}
+
+#ifdef ESP_PLATFORM
+void app_main(void)
+{
+    bench_layouts();
+}
+#else
+int main(void)
+{
+    bench_layouts();
+    return 0;
+}
+#endif